@@ -0,0 +1,75 @@
+#include "Arena.h"
+
+Arena::Arena() : chunks(nullptr), spare(nullptr), next_chunk_size(ARENA_MIN_CHUNK_SIZE) {
+    cursor = initial;
+    end = initial + ARENA_INLINE_SIZE;
+}
+
+Arena::~Arena() {
+    reset();
+    while(spare) {
+        ArenaChunk *next = spare->next;
+        free(spare);
+        spare = next;
+    }
+}
+
+/**
+ * @brief Switch to a new chunk, reusing a spare one if it is large enough
+ * @param size Size of the allocation that did not fit in the current chunk (already rounded)
+ * @return Pointer to the allocated memory
+ */
+void *Arena::allocateSlow(size_t size) {
+    ArenaChunk *chunk;
+    if(spare && spare->size >= size) {
+        chunk = spare;
+        spare = spare->next;
+    }
+    else {
+        size_t chunk_size = size > next_chunk_size ? size : next_chunk_size;
+        chunk = static_cast<ArenaChunk *>(malloc(sizeof(ArenaChunk) + chunk_size));
+        if(!chunk) {
+            throw std::bad_alloc();
+        }
+        chunk->size = chunk_size;
+
+        if(next_chunk_size < ARENA_MAX_CHUNK_SIZE) {
+            next_chunk_size <<= 1;
+        }
+    }
+
+    chunk->next = chunks;
+    chunks = chunk;
+
+    uint8_t *data = (uint8_t *) chunk + sizeof(ArenaChunk);
+    cursor = data + size;
+    end = data + chunk->size;
+    return data;
+}
+
+/**
+ * @brief Release every allocation at once. Chunks are kept for the next use of the arena,
+ * up to ARENA_RETAIN_LIMIT bytes, the rest is given back to the system.
+ */
+void Arena::reset() {
+    size_t retained = 0;
+    for(ArenaChunk *chunk = spare; chunk; chunk = chunk->next) {
+        retained += chunk->size;
+    }
+
+    while(chunks) {
+        ArenaChunk *next = chunks->next;
+        if(retained + chunks->size <= ARENA_RETAIN_LIMIT) {
+            retained += chunks->size;
+            chunks->next = spare;
+            spare = chunks;
+        }
+        else {
+            free(chunks);
+        }
+        chunks = next;
+    }
+
+    cursor = initial;
+    end = initial + ARENA_INLINE_SIZE;
+}
@@ -0,0 +1,146 @@
+#include "ContentionManager.h"
+#include "glob_constants.h"
+#include "macros.h"
+#include <chrono>
+#include <thread>
+
+const char *const contentionManager_policy_names[CONTENTION_POLICY_COUNT] = {
+    "suicide", "backoff", "karma", "polka", "greedy"
+};
+
+/**
+ * @brief State of the calling thread, kept across the attempts of the transaction it is trying to commit.
+ */
+struct ContentionState {
+    uint64_t karma = 0;         // accesses of the aborted attempts
+    uint64_t timestamp = 0;     // start of the first attempt, 0 when there is no pending transaction
+    unsigned int aborts = 0;    // consecutive aborts
+    uint64_t seed = 0;
+};
+
+static thread_local ContentionState contention_state;
+
+static inline void contentionManager_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/**
+ * @brief xorshift64* generator, seeded from the address of the state of the thread
+ */
+static uint64_t contentionManager_random() {
+    if(unlikely(contention_state.seed == 0)) {
+        contention_state.seed = (uint64_t) (uintptr_t) &contention_state | 1;
+    }
+    contention_state.seed ^= contention_state.seed >> 12;
+    contention_state.seed ^= contention_state.seed << 25;
+    contention_state.seed ^= contention_state.seed >> 27;
+    return contention_state.seed * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Spin for a random number of pauses, up to CM_BACKOFF_MIN_SPINS * 2^exponent.
+ * Yields the processor once the window reaches CM_BACKOFF_MAX_SPINS, so that a preempted owner can run.
+ * @param exponent number of times the window was doubled
+ */
+static void contentionManager_backoff(unsigned int exponent) {
+    uint64_t window = CM_BACKOFF_MIN_SPINS;
+    while(exponent-- > 0 && window < CM_BACKOFF_MAX_SPINS) {
+        window <<= 1;
+    }
+
+    uint64_t spins = contentionManager_random() % window + 1;
+    for(uint64_t i = 0; i < spins; i++) {
+        contentionManager_relax();
+    }
+
+    if(window >= CM_BACKOFF_MAX_SPINS) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Priority of a transaction, the higher the stronger
+ */
+static uint64_t contentionManager_priority(Region *region, Transaction *transaction) {
+    if(region->contention_policy == ContentionPolicy::greedy) {
+        return UINT64_MAX - contention_state.timestamp;     // the oldest transaction wins
+    }
+    return contention_state.karma + transaction->accesses;
+}
+
+void contentionManager_on_begin(Region *region, Transaction *unused(transaction)) {
+    if(region->contention_policy == ContentionPolicy::greedy && contention_state.timestamp == 0) {
+        contention_state.timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    if(contention_state.aborts > 0
+            && (region->contention_policy == ContentionPolicy::backoff || region->contention_policy == ContentionPolicy::polka)) {
+        contentionManager_backoff(contention_state.aborts);
+    }
+}
+
+bool contentionManager_on_conflict(Region *region, Transaction *transaction, size_t lock_index, unsigned int attempt) {
+    // The owner is committing and should release soon, but it may be waiting on one of our locks
+    if(attempt >= CM_MAX_ATTEMPTS) {
+        return false;
+    }
+
+    switch(region->contention_policy) {
+        case ContentionPolicy::suicide:
+            return false;
+
+        case ContentionPolicy::backoff:
+            contentionManager_backoff(attempt);
+            return true;
+
+        case ContentionPolicy::karma: {
+            // Every retry adds one to the priority, so that a weaker transaction eventually gets its turn
+            uint64_t priority = contentionManager_priority(region, transaction) + attempt;
+            if(priority < region->getOwnerPriority(lock_index)) {
+                return false;
+            }
+            contentionManager_backoff(0);
+            return true;
+        }
+
+        case ContentionPolicy::polka: {
+            // A stronger transaction waits with exponential backoff, a weaker one gives up
+            // after as many backoff intervals as the priority gap
+            uint64_t priority = contentionManager_priority(region, transaction);
+            uint64_t owner_priority = region->getOwnerPriority(lock_index);
+            if(priority < owner_priority && attempt >= owner_priority - priority) {
+                return false;
+            }
+            contentionManager_backoff(attempt);
+            return true;
+        }
+
+        case ContentionPolicy::greedy:
+        default:
+            if(contentionManager_priority(region, transaction) <= region->getOwnerPriority(lock_index)) {
+                return false;
+            }
+            contentionManager_backoff(0);
+            return true;
+    }
+}
+
+void contentionManager_on_acquire(Region *region, Transaction *transaction, size_t lock_index) {
+    if(region->hasOwnerPriorities()) {
+        region->setOwnerPriority(lock_index, contentionManager_priority(region, transaction));
+    }
+}
+
+void contentionManager_on_end(Region *unused(region), Transaction *transaction, bool committed) {
+    if(committed) {
+        contention_state.karma = 0;
+        contention_state.timestamp = 0;
+        contention_state.aborts = 0;
+    }
+    else {
+        contention_state.karma += transaction->accesses;
+        contention_state.aborts++;
+    }
+}
@@ -0,0 +1,84 @@
+#include "EpochManager.h"
+
+EpochManager::EpochManager(SegmentAllocator &allocator) : allocator(allocator), epoch(0), unannounced(0), limbo{nullptr, nullptr, nullptr} {
+    for(size_t i = 0; i < EBR_SLOTS; i++) {
+        slots[i].store(UINT64_MAX);
+    }
+}
+
+/**
+ * @brief Announce the current epoch for a transaction that begins.
+ * @return Index of the slot holding the announcement, or EBR_SLOTS when all the slots are taken
+ */
+size_t EpochManager::enter() {
+    static thread_local size_t hint = 0;
+    for(size_t i = 0; i < EBR_SLOTS; i++) {
+        size_t slot = (hint + i) % EBR_SLOTS;
+        uint64_t expected = UINT64_MAX;
+        uint64_t current = epoch.load();
+        if(slots[slot].load(std::memory_order_relaxed) == UINT64_MAX && slots[slot].compare_exchange_strong(expected, current)) {
+            // The epoch may have advanced before the announcement was visible
+            uint64_t latest;
+            while((latest = epoch.load()) != current) {
+                slots[slot].store(latest);
+                current = latest;
+            }
+            hint = slot;
+            return slot;
+        }
+    }
+
+    unannounced.fetch_add(1);
+    return EBR_SLOTS;
+}
+
+/**
+ * @brief Withdraw the announcement of a transaction that ended.
+ * @param slot Index returned by enter
+ */
+void EpochManager::exit(size_t slot) {
+    if(slot == EBR_SLOTS) {
+        unannounced.fetch_sub(1);
+    }
+    else {
+        slots[slot].store(UINT64_MAX, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Free a segment once no running transaction can access it any more.
+ * @param segment Segment that no transaction starting from now on can reach
+ */
+void EpochManager::retire(segment_node *segment) {
+    std::lock_guard<std::mutex> guard(limbo_mutex);
+    segment_node *&list = limbo[epoch.load() % 3];
+    segment->next = list;
+    list = segment;
+    tryAdvance();
+}
+
+/**
+ * @brief Advance the epoch if every running transaction announced it, and free the segments retired two
+ * epochs before the new one. Called with the limbo lock held, so that only one thread advances at a time.
+ */
+void EpochManager::tryAdvance() {
+    uint64_t current = epoch.load();
+    if(unannounced.load() != 0) {
+        return;
+    }
+    for(size_t i = 0; i < EBR_SLOTS; i++) {
+        uint64_t announced = slots[i].load();
+        if(announced != UINT64_MAX && announced != current) {
+            return;
+        }
+    }
+    epoch.store(current + 1);
+
+    // The list of the epoch current - 1 is the one the next epoch reuses
+    segment_node *&list = limbo[(current + 2) % 3];
+    while(list) {
+        segment_node *next = list->next;
+        allocator.deallocate(list);
+        list = next;
+    }
+}
@@ -0,0 +1,210 @@
+#include "Etl.h"
+#include "glob_constants.h"
+#include "ContentionManager.h"
+#include <atomic>
+#include <string.h>
+
+/**
+ * @brief Whether a lock state says that the lock is owned by the transaction
+ */
+static inline bool etl_owned_by(uint64_t lock_state, Transaction *transaction) {
+    return lock_state == ((uint64_t) (uintptr_t) transaction | 1);
+}
+
+/**
+ * @brief Release the locks owned by the transaction, which are the locks of the words of its write-set
+ * @param version Version released
+ */
+static void etl_release_locks(Region *region, Transaction *transaction, uint64_t version) {
+    for(WriteRange *range = transaction->writeSet->getHead(); range; range = range->next) {
+        for(size_t offset = 0; offset < range->size; offset += region->align) {
+            // Words sharing a lock release it once
+            size_t lock_index = region->lockIndex(range->address + offset);
+            if(etl_owned_by(region->getSpinLockState(lock_index), transaction)) {
+                region->setAndReleaseSpinLock(lock_index, version);
+            }
+        }
+    }
+}
+
+void etl_rollback(Region *region, Transaction *transaction) {
+    WriteRange *head = transaction->writeSet->getHead();
+    if(!head) {
+        return;
+    }
+
+    for(WriteRange *range = head; range; range = range->next) {
+        memcpy(range->address, range->values(), range->size);
+    }
+    etl_release_locks(region, transaction, region->generateAbortVersion());
+}
+
+/**
+ * @brief Check that no word of the read-set was written since rv. Words whose lock is owned by the
+ * transaction are valid: the lock was taken at a version not newer than rv.
+ */
+static bool etl_validate(Region *region, Transaction *transaction) {
+    for(size_t lock_index : *transaction->readSet) {
+        uint64_t lock_state = region->getSpinLockState(lock_index);
+        if(lock_state & 0x1 ? !etl_owned_by(lock_state, transaction) : lock_state >> 0x1 > transaction->rv) {
+            region->recordConflict(HeatmapEvent::version_failure, lock_index, nullptr);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Extend the snapshot of the transaction to the current clock, if the read-set is still valid.
+ * @param lock_index Index of the lock of the word accessed
+ * @param lock_state State of the lock, unlocked with a version newer than rv
+ * @return Whether the snapshot now includes the word
+ */
+static bool etl_extend(Region *region, Transaction *transaction, size_t lock_index, uint64_t lock_state) {
+    uint64_t version = lock_state >> 0x1;
+    region->observeVersion(version);
+    uint64_t rv = region->getClockVersion();
+
+    if(version > rv) {
+        transaction->abort_cause = StatsCounter::aborts_read_version;
+        return false;
+    }
+    if(!etl_validate(region, transaction)) {
+        transaction->abort_cause = StatsCounter::aborts_validation;
+        return false;
+    }
+
+    // The word must not have been locked meanwhile, by a committer that may share the new read version
+    if(region->getSpinLockState(lock_index) != lock_state) {
+        transaction->abort_cause = StatsCounter::aborts_read_version;
+        return false;
+    }
+    transaction->rv = rv;
+    return true;
+}
+
+bool etl_read(Region *region, Transaction *transaction, void const *source, size_t size, void *target) {
+    for(size_t i = 0; i < size; i += region->align) {
+        void *source_word = (void *) ((uintptr_t) source + i);
+        void *target_word = (void *) ((uintptr_t) target + i);
+        size_t lock_index = region->lockIndex(source_word);
+
+        uint64_t pre_lock_status = region->getSpinLockState(lock_index);
+        memcpy(target_word, source_word, region->align);
+        // The value must be read before the lock is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(pre_lock_status & 0x1) {
+            // Our own writes are in place
+            if(etl_owned_by(pre_lock_status, transaction)) {
+                continue;
+            }
+            transaction->abort_cause = StatsCounter::aborts_read_version;
+            region->recordConflict(HeatmapEvent::version_failure, lock_index, source_word);
+            etl_rollback(region, transaction);
+            return false;
+        }
+
+        // Check if the lock has changed, or if the version is newer than the snapshot and it cannot be extended
+        uint64_t post_lock_status = region->getSpinLockState(lock_index);
+        if(pre_lock_status != post_lock_status) {
+            transaction->abort_cause = StatsCounter::aborts_read_version;
+            region->recordConflict(HeatmapEvent::version_failure, lock_index, source_word);
+            etl_rollback(region, transaction);
+            return false;
+        }
+        if(post_lock_status >> 0x1 > transaction->rv && !etl_extend(region, transaction, lock_index, post_lock_status)) {
+            if(transaction->abort_cause == StatsCounter::aborts_read_version) {
+                region->recordConflict(HeatmapEvent::version_failure, lock_index, source_word);
+            }
+            etl_rollback(region, transaction);
+            return false;
+        }
+
+        transaction->readSet->add(lock_index);
+    }
+
+    return true;
+}
+
+bool etl_write(Region *region, Transaction *transaction, void const *source, size_t size, void *target) {
+    for(size_t i = 0; i < size; i += region->align) {
+        void *source_word = (void *) ((uintptr_t) source + i);
+        void *target_word = (void *) ((uintptr_t) target + i);
+        size_t lock_index = region->lockIndex(target_word);
+
+        bool acquired = false;
+        uint64_t acquired_state = 0;
+        unsigned int attempt = 0;
+        for(;;) {
+            uint64_t lock_state = region->getSpinLockState(lock_index);
+            if(lock_state & 0x1) {
+                if(etl_owned_by(lock_state, transaction)) {
+                    break;
+                }
+                // Taken by another transaction, the contention manager decides whether to wait for it
+                region->recordConflict(HeatmapEvent::acquire_failure, lock_index, target_word);
+                if(!contentionManager_on_conflict(region, transaction, lock_index, attempt++)) {
+                    transaction->abort_cause = StatsCounter::aborts_lock_busy;
+                    etl_rollback(region, transaction);
+                    return false;
+                }
+                continue;
+            }
+
+            // The word may only be locked at a version included in the snapshot,
+            // otherwise a value read before from the same word would not be checked any more
+            if(lock_state >> 0x1 > transaction->rv && !etl_extend(region, transaction, lock_index, lock_state)) {
+                if(transaction->abort_cause == StatsCounter::aborts_read_version) {
+                    region->recordConflict(HeatmapEvent::version_failure, lock_index, target_word);
+                }
+                etl_rollback(region, transaction);
+                return false;
+            }
+            if(region->acquireSpinLockFor(lock_index, lock_state, transaction)) {
+                acquired = true;
+                acquired_state = lock_state;
+                contentionManager_on_acquire(region, transaction, lock_index);
+                break;
+            }
+        }
+
+        // Save the value the word had before the transaction on its first write, then write in place: a word whose lock
+        // was just acquired cannot have been written yet. Without memory for the undo log, the word is left as it was and its lock goes back to the version it was taken at
+        if(acquired || !transaction->writeSet->get(target_word)) {
+            try {
+                transaction->writeSet->write(target_word, target_word, region->align, region->align, transaction->arena.get());
+            } catch (std::bad_alloc& e) {
+                if(acquired) {
+                    region->setAndReleaseSpinLock(lock_index, acquired_state >> 0x1);
+                }
+                throw;
+            }
+        }
+        memcpy(target_word, source_word, region->align);
+    }
+
+    return true;
+}
+
+bool etl_commit(Region *region, Transaction *transaction) {
+    if(!transaction->writeSet->getHead()) {
+        return true;
+    }
+
+    bool must_validate;
+    transaction->wv = region->generateWriteVersion(transaction->rv, &must_validate);
+    if(must_validate) {
+        uint64_t start = transaction->latency ? Latency::now() : 0;
+        if(!etl_validate(region, transaction)) {
+            transaction->abort_cause = StatsCounter::aborts_validation;
+            etl_rollback(region, transaction);
+            return false;
+        }
+        if(transaction->latency) {
+            transaction->latency->record(LatencyPhase::validation, Latency::now() - start);
+        }
+    }
+
+    etl_release_locks(region, transaction, transaction->wv);
+    return true;
+}
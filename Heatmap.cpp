@@ -0,0 +1,103 @@
+#include "Heatmap.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+Heatmap::Heatmap(unsigned int period, const char *file) : period(period), file(file), used(0), sampled(0), dropped(0) {
+    entries = static_cast<HeatmapEntry *>(calloc(HEATMAP_ENTRIES, sizeof(HeatmapEntry)));
+    if(!entries) {
+        throw std::bad_alloc();
+    }
+}
+
+Heatmap::~Heatmap() {
+    free(entries);
+}
+
+/**
+ * @brief Count a sampled conflict against its lock
+ * @param event Kind of the conflict
+ * @param lock_index Index of the lock
+ * @param address Address of the word involved, nullptr if unknown
+ */
+void Heatmap::record(HeatmapEvent event, size_t lock_index, const void *address) {
+    std::lock_guard<std::mutex> guard(mutex);
+    sampled++;
+
+    size_t index = (size_t) ((lock_index * 0x9E3779B97F4A7C15ULL) >> 32) & (HEATMAP_ENTRIES - 1);
+    while(entries[index].used && entries[index].lock_index != lock_index) {
+        index = (index + 1) & (HEATMAP_ENTRIES - 1);
+    }
+
+    HeatmapEntry &entry = entries[index];
+    if(!entry.used) {
+        if(used * 4 >= HEATMAP_ENTRIES * 3) {
+            dropped++;
+            return;
+        }
+        entry.used = true;
+        entry.lock_index = lock_index;
+        used++;
+    }
+
+    if(event == HeatmapEvent::acquire_failure) {
+        entry.acquire_failures++;
+    }
+    else {
+        entry.version_failures++;
+    }
+
+    if(address && std::find(entry.addresses, entry.addresses + entry.address_count, address) == entry.addresses + entry.address_count) {
+        if(entry.address_count < HEATMAP_ADDRESSES) {
+            entry.addresses[entry.address_count++] = address;
+        }
+        else {
+            entry.more_addresses = true;
+        }
+    }
+}
+
+/**
+ * @brief Write the locks that met conflicts to a file, the most conflicted first, one per line:
+ * index of the lock, acquire failures, version failures, and the addresses seen ("+" when there were more)
+ * @param path Path of the file, overwritten
+ * @param lock_count Number of locks in the table
+ * @return Whether the file was written
+ */
+bool Heatmap::dump(const char *path, size_t lock_count) {
+    std::vector<HeatmapEntry> hot;
+    uint64_t total_sampled, total_dropped;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        for(size_t i = 0; i < HEATMAP_ENTRIES; i++) {
+            if(entries[i].used) {
+                hot.push_back(entries[i]);
+            }
+        }
+        total_sampled = sampled;
+        total_dropped = dropped;
+    }
+    std::sort(hot.begin(), hot.end(), [](const HeatmapEntry &a, const HeatmapEntry &b) {
+        uint64_t a_total = a.acquire_failures + a.version_failures, b_total = b.acquire_failures + b.version_failures;
+        return a_total != b_total ? a_total > b_total : a.lock_index < b.lock_index;
+    });
+
+    FILE *file = fopen(path, "w");
+    if(!file) {
+        return false;
+    }
+    fprintf(file, "# lock-table heatmap: %zu locks, 1 conflict sampled out of %u, %llu sampled, %llu dropped\n",
+        lock_count, period, (unsigned long long) total_sampled, (unsigned long long) total_dropped);
+    fprintf(file, "# lock acquire_failures version_failures addresses\n");
+    for(const HeatmapEntry &entry : hot) {
+        fprintf(file, "%zu %llu %llu", entry.lock_index,
+            (unsigned long long) entry.acquire_failures, (unsigned long long) entry.version_failures);
+        for(size_t i = 0; i < entry.address_count; i++) {
+            fprintf(file, " %p", entry.addresses[i]);
+        }
+        fprintf(file, "%s\n", entry.more_addresses ? " +" : "");
+    }
+
+    return fclose(file) == 0;
+}
@@ -0,0 +1,101 @@
+#include "Latency.h"
+#include "PageMemory.h"
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+static const char *const latency_phase_names[] = { "commit", "abort", "commit_phase", "lock_acquisition", "validation" };
+
+Latency::Latency(unsigned int period, const char *file) : period(period), file(file) {
+    // The atomics of the histograms start zeroed, as the mapping does
+    slots = static_cast<LatencySlot *>(pageMemory_map(STATS_SLOTS * sizeof(LatencySlot)));
+    if(!slots) {
+        throw std::bad_alloc();
+    }
+}
+
+Latency::~Latency() {
+    pageMemory_unmap(slots, STATS_SLOTS * sizeof(LatencySlot));
+}
+
+/**
+ * @brief Slot of the calling thread, threads are mapped to the slots in turn
+ * @return The slot
+ */
+LatencySlot *Latency::slot() {
+    static std::atomic<size_t> next_index(0);
+    static thread_local size_t index = next_index.fetch_add(1) % STATS_SLOTS;
+    return &slots[index];
+}
+
+/**
+ * @brief Merge the histograms of a phase over the slots
+ * @param phase Phase to merge
+ * @param merged Empty histogram receiving the samples of every slot
+ */
+void Latency::merge(LatencyPhase phase, LatencyHistogram *merged) {
+    for(size_t s = 0; s < STATS_SLOTS; s++) {
+        merged->merge(slots[s].histograms[static_cast<size_t>(phase)]);
+    }
+}
+
+/**
+ * @brief Duration under which a fraction of the samples of a phase fall, over all the threads
+ * @param phase Phase to query
+ * @param fraction Fraction of the samples, between 0 and 1
+ * @return Duration in nanoseconds, 0 if there is no sample
+ */
+uint64_t Latency::percentile(LatencyPhase phase, double fraction) {
+    std::unique_ptr<LatencyHistogram> merged(new LatencyHistogram());
+    merge(phase, merged.get());
+    return merged->percentile(fraction);
+}
+
+/**
+ * @brief Write the merged histograms to a file: a summary line per phase with its percentiles, then the
+ * non-empty buckets of every phase with their upper bound, count and cumulative fraction
+ * @param path Path of the file, overwritten
+ * @return Whether the file was written
+ */
+bool Latency::dump(const char *path) {
+    const size_t phases = static_cast<size_t>(LatencyPhase::count);
+    std::vector<LatencyHistogram> merged(phases);
+    for(size_t phase = 0; phase < phases; phase++) {
+        merge(static_cast<LatencyPhase>(phase), &merged[phase]);
+    }
+
+    FILE *file = fopen(path, "w");
+    if(!file) {
+        return false;
+    }
+
+    fprintf(file, "# transaction latencies in nanoseconds, 1 transaction timed out of %u\n", period);
+    for(size_t phase = 0; phase < phases; phase++) {
+        const LatencyHistogram &histogram = merged[phase];
+        fprintf(file, "%s count=%llu p50=%llu p90=%llu p99=%llu p99.9=%llu max=%llu\n", latency_phase_names[phase],
+            (unsigned long long) histogram.total(),
+            (unsigned long long) histogram.percentile(0.5),
+            (unsigned long long) histogram.percentile(0.9),
+            (unsigned long long) histogram.percentile(0.99),
+            (unsigned long long) histogram.percentile(0.999),
+            (unsigned long long) histogram.max());
+    }
+
+    fprintf(file, "# phase bucket_upper_bound_ns count cumulative_fraction\n");
+    for(size_t phase = 0; phase < phases; phase++) {
+        const LatencyHistogram &histogram = merged[phase];
+        uint64_t total = histogram.total();
+        uint64_t seen = 0;
+        for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            uint64_t count = histogram.count(i);
+            if(count == 0) {
+                continue;
+            }
+            seen += count;
+            fprintf(file, "%s %llu %llu %.6f\n", latency_phase_names[phase], (unsigned long long) LatencyHistogram::upperBound(i),
+                (unsigned long long) count, (double) seen / total);
+        }
+    }
+
+    return fclose(file) == 0;
+}
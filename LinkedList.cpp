@@ -3,15 +3,7 @@
 LinkedList::LinkedList() {
     head = nullptr;
     tail = nullptr;
-}
-
-LinkedList::~LinkedList() {
-    Node *node = head;
-    while(node) {
-        Node *next = node->next;
-        delete node;
-        node = next;
-    }
+    count = 0;
 }
 
 /**
@@ -27,6 +19,20 @@ void LinkedList::add(Node *node) {
         tail->next = node;
         tail = node;
     }
+    count++;
+}
+
+/**
+ * @brief Add a node to the head of the linked list
+ * @param node Node to add, the list is then traversed from the most recent node
+ */
+void LinkedList::push(Node *node) {
+    node->next = head;
+    head = node;
+    if(!tail) {
+        tail = node;
+    }
+    count++;
 }
 
 /**
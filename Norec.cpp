@@ -0,0 +1,96 @@
+#include "Norec.h"
+#include "glob_constants.h"
+#include "LinkedList.h"
+#include "WriteSet.h"
+#include <atomic>
+#include <thread>
+#include <string.h>
+
+uint64_t norec_snapshot(Region *region) {
+    uint64_t version;
+    unsigned int spins = 0;
+    while((version = region->getClockVersion()) & 0x1) {
+        // The writer may have been preempted in the middle of its write-back
+        if(++spins % NOREC_SPINS_BEFORE_YIELD == 0) {
+            std::this_thread::yield();
+        }
+    }
+    return version;
+}
+
+/**
+ * @brief Check that every value of the read-set is still in memory, at a time no transaction writes back.
+ * On success, the read version of the transaction is advanced to that time.
+ * @param region the region of the transaction
+ * @param transaction the transaction to validate
+ * @return whether the read-set is still valid
+ */
+static bool norec_validate(Region *region, Transaction *transaction) {
+    for(;;) {
+        uint64_t version = norec_snapshot(region);
+
+        Node *node = transaction->readList->getHead();
+        while(node) {
+            if(memcmp(node->address, node->val, region->align) != 0) {
+                transaction->abort_cause = StatsCounter::aborts_validation;
+                return false;
+            }
+            node = node->next;
+        }
+
+        // The values must all have been read before the clock is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(region->getClockVersion() == version) {
+            transaction->rv = version;
+            return true;
+        }
+    }
+}
+
+bool norec_read(Region *region, Transaction *transaction, void const *source, size_t size, void *target) {
+    for(size_t i = 0; i < size; i += region->align) {
+        void *source_word = (void *) ((uintptr_t) source + i);
+        void *target_word = (void *) ((uintptr_t) target + i);
+
+        if(!transaction->is_ro) {
+            void *value = transaction->writeSet->get(source_word);
+            if(value) {
+                memcpy(target_word, value, region->align);
+                continue;
+            }
+        }
+
+        // The value is consistent with the read-set as long as no transaction committed since rv
+        memcpy(target_word, source_word, region->align);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        while(region->getClockVersion() != transaction->rv) {
+            if(!norec_validate(region, transaction)) {
+                return false;
+            }
+            memcpy(target_word, source_word, region->align);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+
+        // Log the value read, to validate it later on
+        Node *newNode = transaction_new_node(transaction, source_word, target_word, region->align);
+        transaction->readList->add(newNode);
+    }
+
+    return true;
+}
+
+bool norec_commit(Region *region, Transaction *transaction) {
+    uint64_t start = transaction->latency ? Latency::now() : 0;
+    while(!region->tryLockClock(transaction->rv)) {
+        if(!norec_validate(region, transaction)) {
+            return false;
+        }
+    }
+    if(transaction->latency) {
+        transaction->latency->record(LatencyPhase::lock_acquisition, Latency::now() - start);
+    }
+
+    transaction_write_back(transaction, region);
+    region->unlockClock(transaction->rv + 2);
+    return true;
+}
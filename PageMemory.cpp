@@ -0,0 +1,24 @@
+#include "PageMemory.h"
+#include <sys/mman.h>
+
+void *pageMemory_map(size_t bytes) {
+    void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED) {
+        return nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if(bytes >= HUGE_PAGE_SIZE) {
+        // Only a hint, the mapping is still usable if the kernel refuses
+        madvise(memory, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    return memory;
+}
+
+void pageMemory_unmap(void *memory, size_t bytes) {
+    if(memory) {
+        munmap(memory, bytes);
+    }
+}
@@ -0,0 +1,41 @@
+#include "ReadSet.h"
+#include <string.h>
+
+ReadSet::ReadSet() : capacity(READ_SET_INITIAL_CAPACITY), count(0) {
+    indices = static_cast<size_t *>(malloc(capacity * sizeof(size_t)));
+    if(!indices) {
+        throw std::bad_alloc();
+    }
+    memset(filter, 0, sizeof(filter));
+}
+
+ReadSet::~ReadSet() {
+    free(indices);
+}
+
+/**
+ * @brief Double the capacity of the array
+ */
+void ReadSet::grow() {
+    size_t *new_indices = static_cast<size_t *>(realloc(indices, (capacity << 1) * sizeof(size_t)));
+    if(!new_indices) {
+        throw std::bad_alloc();
+    }
+    indices = new_indices;
+    capacity <<= 1;
+}
+
+/**
+ * @brief Empty the read-set, keeping the array for the next transaction unless it grew
+ * beyond READ_SET_RETAIN_CAPACITY, in which case it is shrunk back to that capacity
+ */
+void ReadSet::reset() {
+    if(unlikely(capacity > READ_SET_RETAIN_CAPACITY)) {
+        size_t *small_indices = static_cast<size_t *>(realloc(indices, READ_SET_RETAIN_CAPACITY * sizeof(size_t)));
+        if(small_indices) {
+            indices = small_indices;
+            capacity = READ_SET_RETAIN_CAPACITY;
+        }
+    }
+    count = 0;
+}
@@ -1,32 +1,141 @@
 #include "Region.h"
 #include "glob_constants.h"
 #include "VersionSpinLock.h"
+#include "PageMemory.h"
+#include "Word.h"
 #include <stdlib.h>
 #include <string.h>
 
 
-Region::Region(size_t size, size_t align) : size(size), align(align) {
-    if(posix_memalign(&start, align, size) != 0) {
-        throw std::bad_alloc();
-    }
+Region::Region(size_t size, size_t align, const RegionConfig &config)
+    : start(nullptr), locks(nullptr), lock_mask(config.lock_table_size - 1), owner_priorities(nullptr), history(nullptr),
+      size(size), align(align), engine(config.engine),
+      align_shift(__builtin_ctzl(align)), word_size(word_size_for(align)), clock_policy(config.clock_policy), contention_policy(config.contention_policy),
+      allocator(align), epochs(allocator), heatmap(nullptr), latency(nullptr), trace(nullptr) {
+    // Every member released by release() is null until it is allocated, so a failure only has to release them all
+    try {
+        // NOrec has no per-word metadata
+        if(engine == TmEngine::norec) {
+            lock_mask = 0;
+        }
+        else {
+            // The versioned write spinlocks come zeroed (unlocked, version 0) from the kernel
+            locks = static_cast<VersionSpinLock *>(pageMemory_map(getLockCount() * sizeof(VersionSpinLock)));
+            if(!locks) {
+                throw std::bad_alloc();
+            }
+        }
+
+        // Only the priority-based contention policies need to know who owns a lock
+        if(locks && (contention_policy == ContentionPolicy::karma || contention_policy == ContentionPolicy::polka
+                || contention_policy == ContentionPolicy::greedy)) {
+            owner_priorities = static_cast<std::atomic<uint64_t> *>(pageMemory_map(getLockCount() * sizeof(std::atomic<uint64_t>)));
+            if(!owner_priorities) {
+                throw std::bad_alloc();
+            }
+        }
+
+        if(config.mv_depth > 0) {
+            history = new VersionHistory(getLockCount(), config.mv_depth, align);
+        }
+
+        // posix_memalign requires a multiple of sizeof(void *), which is also aligned on the smaller alignments
+        if(posix_memalign(&start, align > sizeof(void *) ? align : sizeof(void *), size) != 0) {
+            start = nullptr;
+            throw std::bad_alloc();
+        }
 
-    // Initialize versioned write spinlocks
-    for (int i = 0; i < LOCK_ARRAY_SIZE; i++) {
-        versionSpinLock_init(&locks[i]);
+        if(config.heatmap_period > 0) {
+            heatmap = new Heatmap(config.heatmap_period, config.heatmap_file);
+        }
+        if(config.latency_period > 0) {
+            latency = new Latency(config.latency_period, config.latency_file);
+        }
+        if(config.trace_events > 0) {
+            trace = new Trace(config.trace_events, config.trace_file);
+        }
+    } catch (std::bad_alloc& e) {
+        release();
+        throw;
     }
 
-    // Initialize the region global version clock
+    // Initialize the region global version clock, even as the NOrec sequence lock is taken while odd
     memset(start, 0, size);
-    clock.store(0);
-    allocs = nullptr;
+    clock.store(CLOCK_INITIAL_VERSION & ~(uint64_t) 0x1);
 }
 
-Region::~Region() {
-    while (allocs) { // Free allocated segments
-        segment_list tail = allocs->next;
-        free(allocs);
-        allocs = tail;
+/**
+ * @brief Release the memory of the region, for the destructor and for a constructor that failed half-way.
+ * The members not allocated yet are null.
+ */
+void Region::release() {
+    free(start);
+    pageMemory_unmap(locks, getLockCount() * sizeof(VersionSpinLock));
+    pageMemory_unmap(owner_priorities, getLockCount() * sizeof(std::atomic<uint64_t>));
+    delete history;
+    delete heatmap;
+    delete latency;
+    delete trace;
+}
+
+/**
+ * @brief Generate the write version of a committing transaction, which must hold all its write locks.
+ * Several transactions can share a write version with gv4, gv5 and gv6: this is safe because a
+ * transaction that starts once the clock reaches that version finds the locks of every such committer taken.
+ * @param rv Read version of the committing transaction
+ * @param must_validate Set to false when no transaction can have committed since rv, so that the read-set
+ * does not need to be validated
+ * @return The write version
+ */
+uint64_t Region::generateWriteVersion(uint64_t rv, bool *must_validate) {
+    static thread_local uint32_t gv6_counter = 0;
+
+    switch(clock_policy) {
+        case ClockPolicy::gv4: {
+            uint64_t current = clock.load();
+            if(clock.compare_exchange_strong(current, current + 1)) {
+                *must_validate = rv + 1 != current + 1;
+                return current + 1;
+            }
+            // Pass on failure: current now holds the version installed by the winner
+            *must_validate = true;
+            return current;
+        }
+        case ClockPolicy::gv5:
+            *must_validate = true;
+            return clock.load() + 1;
+        case ClockPolicy::gv6:
+            // The read-set is always validated: even when the clock is incremented, transactions
+            // that took the gv5 path may have committed since rv without advancing it
+            *must_validate = true;
+            if(++gv6_counter % GV6_SAMPLE_PERIOD != 0) {
+                return clock.load() + 1;
+            }
+            return clock.fetch_add(1) + 1;
+        case ClockPolicy::gv1:
+        default: {
+            uint64_t wv = clock.fetch_add(1) + 1;
+            *must_validate = rv + 1 != wv;
+            return wv;
+        }
     }
+}
 
-    free(start);
-}
\ No newline at end of file
+/**
+ * @brief Generate the version that the locks of a transaction rolling back its writes in place are released with.
+ * It must differ from the versions the locks had before, otherwise a concurrent reader could take a value that
+ * was undone for a consistent one.
+ * @return A version newer than any version installed so far
+ */
+uint64_t Region::generateAbortVersion() {
+    uint64_t version = clock.fetch_add(1) + 1;
+    if(clock_policy == ClockPolicy::gv5 || clock_policy == ClockPolicy::gv6) {
+        // A lock may already carry the version following the clock
+        version++;
+    }
+    return version;
+}
+
+Region::~Region() {
+    release();
+}
@@ -0,0 +1,103 @@
+#include "RegionConfig.h"
+#include "glob_constants.h"
+#include "ContentionManager.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Round up to the next power of 2
+ * @param value Value to round, must be positive
+ * @return The smallest power of 2 greater or equal to value
+ */
+static size_t regionConfig_next_pow2(size_t value) {
+    size_t pow2 = 1;
+    while(pow2 < value) {
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+/**
+ * @brief Read a positive size from the environment
+ * @param name Name of the variable
+ * @param fallback Value returned when the variable is unset or invalid
+ * @return The parsed value
+ */
+static size_t regionConfig_env_size(const char *name, size_t fallback) {
+    const char *value = getenv(name);
+    if(!value || !*value) {
+        return fallback;
+    }
+
+    char *end;
+    unsigned long long parsed = strtoull(value, &end, 0);
+    return (*end == '\0' && parsed > 0) ? (size_t) parsed : fallback;
+}
+
+/**
+ * @brief Read a choice among a list of names from the environment
+ * @param name Name of the variable
+ * @param choices Accepted values
+ * @param count Number of accepted values
+ * @param fallback Index returned when the variable is unset or not one of the choices
+ * @return Index of the value in choices
+ */
+static size_t regionConfig_env_choice(const char *name, const char *const *choices, size_t count, size_t fallback) {
+    const char *value = getenv(name);
+    if(!value) {
+        return fallback;
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        if(strcmp(value, choices[i]) == 0) {
+            return i;
+        }
+    }
+    return fallback;
+}
+
+RegionConfig regionConfig_from_env(size_t size, size_t align) {
+    RegionConfig config;
+
+    static const char *const engines[] = { "tl2", "norec", "etl" };
+    config.engine = static_cast<TmEngine>(regionConfig_env_choice("TM_ENGINE", engines, 3, 0));
+
+    // One lock per word of the first segment, within bounds: the table is lazily zeroed by the kernel,
+    // so the lower bound costs nothing until used, and it leaves room for the dynamically allocated segments
+    size_t lock_table_size = regionConfig_next_pow2(size / align);
+    if(lock_table_size < LOCK_TABLE_MIN_SIZE) lock_table_size = LOCK_TABLE_MIN_SIZE;
+    if(lock_table_size > LOCK_TABLE_MAX_SIZE) lock_table_size = LOCK_TABLE_MAX_SIZE;
+
+    lock_table_size = regionConfig_env_size("TM_LOCK_TABLE_SIZE", lock_table_size);
+    if(lock_table_size > LOCK_TABLE_MAX_SIZE) lock_table_size = LOCK_TABLE_MAX_SIZE;
+    config.lock_table_size = regionConfig_next_pow2(lock_table_size);
+
+    static const char *const clock_policies[] = { "gv1", "gv4", "gv5", "gv6" };
+    config.clock_policy = static_cast<ClockPolicy>(regionConfig_env_choice("TM_CLOCK", clock_policies, 4, 0));
+
+    config.contention_policy = static_cast<ContentionPolicy>(regionConfig_env_choice("TM_CONTENTION",
+        contentionManager_policy_names, CONTENTION_POLICY_COUNT, static_cast<size_t>(ContentionPolicy::backoff)));
+
+
+    // Multi-version mode, only with tl2
+    size_t mv_depth = regionConfig_env_size("TM_MV_DEPTH", 0);
+    config.mv_depth = config.engine == TmEngine::tl2 ? (unsigned int) (mv_depth < MV_MAX_DEPTH ? mv_depth : MV_MAX_DEPTH) : 0;
+
+    // Contention heatmap, there is no lock table with norec
+    size_t heatmap_period = regionConfig_env_size("TM_HEATMAP", 0);
+    config.heatmap_period = config.engine != TmEngine::norec ? (unsigned int) (heatmap_period < UINT32_MAX ? heatmap_period : UINT32_MAX) : 0;
+    const char *heatmap_file = getenv("TM_HEATMAP_FILE");
+    config.heatmap_file = heatmap_file && *heatmap_file ? heatmap_file : "tm_heatmap.txt";
+
+    size_t latency_period = regionConfig_env_size("TM_LATENCY", 0);
+    config.latency_period = (unsigned int) (latency_period < UINT32_MAX ? latency_period : UINT32_MAX);
+    const char *latency_file = getenv("TM_LATENCY_FILE");
+    config.latency_file = latency_file && *latency_file ? latency_file : "tm_latency.txt";
+
+    // Rounded up to a power of 2 by the trace
+    size_t trace_events = regionConfig_env_size("TM_TRACE", 0);
+    config.trace_events = trace_events < TRACE_MAX_EVENTS ? trace_events : TRACE_MAX_EVENTS;
+    const char *trace_file = getenv("TM_TRACE_FILE");
+    config.trace_file = trace_file && *trace_file ? trace_file : "tm_trace.json";
+    return config;
+}
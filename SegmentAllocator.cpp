@@ -0,0 +1,196 @@
+#include "SegmentAllocator.h"
+#include "PageMemory.h"
+#include <string.h>
+
+/**
+ * @brief Get the cache of the calling thread. Threads are given consecutive caches in the order in which
+ * they first allocate or free, and only share one when there are more than ALLOC_CACHES of them.
+ * @return Index of the cache
+ */
+static size_t segmentAllocator_cache_index() {
+    static std::atomic<size_t> next_index(0);
+    static thread_local size_t index = next_index.fetch_add(1) % ALLOC_CACHES;
+    return index;
+}
+
+SegmentAllocator::SegmentAllocator(size_t align)
+    : header_size(align > sizeof(struct segment_node) ? align : sizeof(struct segment_node)), slabs(nullptr) {
+    for(Cache &cache : caches) {
+        for(size_t i = 0; i < ALLOC_CLASSES; i++) {
+            cache.blocks[i] = nullptr;
+            cache.count[i] = 0;
+        }
+    }
+    for(SizeClass &size_class : classes) {
+        size_class.blocks = nullptr;
+        size_class.cursor = nullptr;
+        size_class.end = nullptr;
+    }
+}
+
+SegmentAllocator::~SegmentAllocator() {
+    AllocatorSlab *slab = slabs.load();
+    while(slab) {
+        AllocatorSlab *next = slab->next;
+        pageMemory_unmap(slab->memory, slab->bytes);
+        slab = next;
+    }
+}
+
+/**
+ * @brief Get the size of the blocks of a size class. Class 4g + s holds blocks of (4 + s) << (g + ALLOC_MIN_CLASS_SHIFT - 2)
+ * bytes, rounded up to a multiple of the header size so that consecutive blocks keep the alignment of the segments.
+ * @param size_class Size class
+ * @return Size of the blocks in bytes
+ */
+size_t SegmentAllocator::blockSize(size_t size_class) {
+    size_t size = (4 + size_class % 4) << (size_class / 4 + ALLOC_MIN_CLASS_SHIFT - 2);
+    return (size + header_size - 1) & ~(header_size - 1);
+}
+
+/**
+ * @brief Get the smallest size class holding blocks of a given size
+ * @param block Size of the segment plus its header
+ * @return Size class, possibly ALLOC_CLASSES or more if the block is too large
+ */
+size_t SegmentAllocator::sizeClass(size_t block) {
+    if(block <= ((size_t) 1 << ALLOC_MIN_CLASS_SHIFT)) {
+        return 0;
+    }
+    // With 2^k <= block - 1 < 2^(k+1), the two bits after the leading one select the quarter
+    size_t n = block - 1;
+    size_t k = 63 - __builtin_clzl(n);
+    size_t quarter = (n >> (k - 2)) & 3;
+    return (k - ALLOC_MIN_CLASS_SHIFT) * 4 + quarter + 1;
+}
+
+/**
+ * @brief Allocate a zero-filled segment, aligned on the alignment of the region
+ * @param size Size of the segment in bytes
+ * @return Header of the segment, or nullptr if the memory is exhausted
+ */
+segment_list SegmentAllocator::allocate(size_t size) {
+    size_t block = header_size + size;
+    if(block < size) {
+        return nullptr;
+    }
+    size_t size_class = sizeClass(block);
+    if(size_class >= ALLOC_CLASSES) {
+        return nullptr;
+    }
+
+    Cache &cache = caches[segmentAllocator_cache_index()];
+    cache.mutex.lock();
+    if(!cache.blocks[size_class] && !refill(cache, size_class)) {
+        cache.mutex.unlock();
+        return nullptr;
+    }
+    segment_list segment = cache.blocks[size_class];
+    cache.blocks[size_class] = segment->next;
+    cache.count[size_class]--;
+    cache.mutex.unlock();
+
+    segment->next = nullptr;
+    memset(segmentStart(segment), 0, size);
+    return segment;
+}
+
+/**
+ * @brief Give a segment back for later allocations
+ * @param segment Header returned by allocate
+ */
+void SegmentAllocator::deallocate(segment_list segment) {
+    size_t size_class = segment->size_class;
+    Cache &cache = caches[segmentAllocator_cache_index()];
+
+    std::lock_guard<std::mutex> guard(cache.mutex);
+    segment->next = cache.blocks[size_class];
+    cache.blocks[size_class] = segment;
+    if(++cache.count[size_class] * blockSize(size_class) > ALLOC_CACHE_BYTES && cache.count[size_class] > 1) {
+        flush(cache, size_class);
+    }
+}
+
+/**
+ * @brief Fill an empty cache with a batch of blocks, taken from the shared free list of the size class first,
+ * then from the last slab of the class. A new slab is mapped only if neither has any block left.
+ * Called with the lock of the cache held.
+ * @param cache Cache of the calling thread
+ * @param size_class Size class of the blocks
+ * @return Whether at least one block was added
+ */
+bool SegmentAllocator::refill(Cache &cache, size_t size_class) {
+    size_t block = blockSize(size_class);
+    size_t batch = ALLOC_CACHE_BYTES / 2 / block;
+    batch = batch ? batch : 1;
+
+    SizeClass &shared = classes[size_class];
+    std::lock_guard<std::mutex> guard(shared.mutex);
+    while(cache.count[size_class] < batch) {
+        segment_list segment;
+        if(shared.blocks) {
+            segment = shared.blocks;
+            shared.blocks = segment->next;
+        }
+        else if((size_t) (shared.end - shared.cursor) >= block) {
+            segment = (segment_list) (shared.cursor + header_size - sizeof(struct segment_node));
+            segment->size_class = size_class;
+            shared.cursor += block;
+        }
+        else if(cache.count[size_class] == 0) {
+            // The blocks start on a multiple of header_size and their sizes are multiples of it, so the segments
+            // stay aligned. The mapping is only page-aligned, which is not enough for alignments beyond a page
+            size_t blocks_bytes = block > ALLOC_SLAB_SIZE ? block : ALLOC_SLAB_SIZE / block * block;
+            size_t bytes = header_size - 1 + blocks_bytes + sizeof(AllocatorSlab);
+            uint8_t *memory = static_cast<uint8_t *>(pageMemory_map(bytes));
+            if(!memory) {
+                return false;
+            }
+            uint8_t *blocks = (uint8_t *) (((uintptr_t) memory + header_size - 1) & ~(uintptr_t) (header_size - 1));
+            AllocatorSlab *slab = (AllocatorSlab *) (blocks + blocks_bytes);
+            slab->memory = memory;
+            slab->bytes = bytes;
+            slab->next = slabs.load();
+            while(!slabs.compare_exchange_weak(slab->next, slab)) {}
+
+            shared.cursor = blocks;
+            shared.end = blocks + blocks_bytes;
+            continue;
+        }
+        else {
+            break;
+        }
+
+        segment->next = cache.blocks[size_class];
+        cache.blocks[size_class] = segment;
+        cache.count[size_class]++;
+    }
+    return true;
+}
+
+/**
+ * @brief Move half of the blocks of a cache which grew beyond ALLOC_CACHE_BYTES to the shared free list
+ * of the size class, where the other threads can reuse them. Called with the lock of the cache held.
+ * @param cache Cache of the calling thread
+ * @param size_class Size class of the blocks
+ */
+void SegmentAllocator::flush(Cache &cache, size_t size_class) {
+    size_t keep = cache.count[size_class] / 2;
+    segment_list *link = &cache.blocks[size_class];
+    for(size_t i = 0; i < keep; i++) {
+        link = &(*link)->next;
+    }
+    segment_list moved = *link;
+    *link = nullptr;
+    cache.count[size_class] = keep;
+
+    segment_list last = moved;
+    while(last->next) {
+        last = last->next;
+    }
+
+    SizeClass &shared = classes[size_class];
+    std::lock_guard<std::mutex> guard(shared.mutex);
+    last->next = shared.blocks;
+    shared.blocks = moved;
+}
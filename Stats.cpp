@@ -0,0 +1,32 @@
+#include "Stats.h"
+
+Stats::Stats() {
+    for(StatsSlot &slot : slots) {
+        for(std::atomic<uint64_t> &counter : slot.counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Slot of the calling thread, threads are mapped to the slots in turn
+ * @return The slot
+ */
+StatsSlot *Stats::slot() {
+    static std::atomic<size_t> next_index(0);
+    static thread_local size_t index = next_index.fetch_add(1) % STATS_SLOTS;
+    return &slots[index];
+}
+
+/**
+ * @brief Sum a counter over the slots. The sum is not a snapshot: the counters keep changing while they are read
+ * @param counter Counter to sum
+ * @return The sum
+ */
+uint64_t Stats::total(StatsCounter counter) {
+    uint64_t sum = 0;
+    for(StatsSlot &slot : slots) {
+        sum += slot.counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
@@ -0,0 +1,187 @@
+#include "Trace.h"
+#include "Latency.h"
+#include "Stats.h"
+#include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
+
+static std::atomic<uint64_t> trace_next_id(1);
+
+Trace::Trace(size_t events, const char *file) : id(trace_next_id.fetch_add(1)),
+    capacity(events > 1 ? 1ULL << (64 - __builtin_clzll(events - 1)) : 1), file(file), origin(Latency::now()),
+    untraced_transactions(0) {
+    buffers.reserve(TRACE_THREADS);
+}
+
+Trace::~Trace() {
+    for(TraceBuffer *buffer : buffers) {
+        free(buffer->records);
+        delete buffer;
+    }
+}
+
+/**
+ * @brief Buffer of the calling thread, created on its first transaction. The last buffer used by the thread is
+ * cached, so a thread only takes the mutex when it moves to another traced region
+ * @return The buffer, or nullptr if the thread is not traced: TRACE_THREADS threads already have a buffer,
+ * or memory ran out, which does not prevent the transaction from running
+ */
+TraceBuffer *Trace::buffer() {
+    static thread_local uint64_t cached_id = 0;
+    static thread_local TraceBuffer *cached = nullptr;
+    if(cached_id == id) {
+        return cached;
+    }
+
+    std::thread::id self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> guard(mutex);
+    TraceBuffer *found = nullptr;
+    for(TraceBuffer *buffer : buffers) {
+        if(buffer->owner == self) {
+            found = buffer;
+            break;
+        }
+    }
+    if(!found && buffers.size() < TRACE_THREADS) {
+        TraceRecord *records = static_cast<TraceRecord *>(malloc(capacity * sizeof(TraceRecord)));
+        found = records ? new (std::nothrow) TraceBuffer(self, (uint32_t) buffers.size(), capacity, records) : nullptr;
+        if(found) {
+            buffers.push_back(found);
+        }
+        else {
+            free(records);
+        }
+    }
+    if(!found) {
+        untraced_transactions++;
+        return nullptr;
+    }
+    cached_id = id;
+    cached = found;
+    return found;
+}
+
+/**
+ * @brief Name of the cause of an abort, as recorded in the detail of the event
+ * @param detail Detail of the abort event
+ * @return The name
+ */
+static const char *trace_cause_name(uint8_t detail) {
+    switch(static_cast<StatsCounter>(detail)) {
+        case StatsCounter::aborts_read_version:
+            return "read_version";
+        case StatsCounter::aborts_validation:
+            return "validation";
+        case StatsCounter::aborts_lock_busy:
+            return "lock_busy";
+        case StatsCounter::aborts_no_memory:
+            return "no_memory";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief Write a time relative to the origin of the trace in microseconds, the unit of the trace_event format
+ * @param file File to write to
+ * @param time Time of the event
+ * @param origin Origin of the trace
+ */
+static void trace_timestamp(FILE *file, uint64_t time, uint64_t origin) {
+    uint64_t ns = time > origin ? time - origin : 0;
+    fprintf(file, "%llu.%03llu", (unsigned long long) (ns / 1000), (unsigned long long) (ns % 1000));
+}
+
+/**
+ * @brief Write the events of the threads to a file in the Chrome trace_event JSON format (chrome://tracing, Perfetto).
+ * The buffers may be written while the threads run: the events they overwrite during the copy are left out
+ * @param path Path of the file, overwritten
+ * @return Whether the file was written
+ */
+bool Trace::dump(const char *path) {
+    std::vector<std::vector<TraceRecord>> events;
+    uint64_t untraced;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        for(TraceBuffer *buffer : buffers) {
+            uint64_t end = buffer->next.load(std::memory_order_acquire);
+            uint64_t start = end > capacity ? end - capacity : 0;
+            std::vector<TraceRecord> copy(end - start);
+            for(uint64_t position = start; position < end; position++) {
+                copy[position - start] = buffer->records[position & buffer->mask];
+            }
+
+            // The event being recorded overwrites the oldest one, so one more than the events recorded meanwhile
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t overwritten = buffer->next.load(std::memory_order_relaxed) + 1;
+            overwritten = overwritten > capacity ? overwritten - capacity : 0;
+            copy.erase(copy.begin(), copy.begin() + (overwritten > start ? std::min(overwritten - start, end - start) : 0));
+            events.push_back(std::move(copy));
+        }
+        untraced = untraced_transactions;
+    }
+
+    FILE *file = fopen(path, "w");
+    if(!file) {
+        return false;
+    }
+    int pid = (int) getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"events_per_thread\":%llu,\"untraced_transactions\":%llu},\n",
+        (unsigned long long) capacity, (unsigned long long) untraced);
+    fprintf(file, "\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"tm\"}}", pid);
+
+    for(size_t thread = 0; thread < events.size(); thread++) {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%zu,\"args\":{\"name\":\"thread %zu\"}}",
+            pid, thread, thread);
+
+        // A transaction whose begin event was overwritten ends with an instant instead of a slice
+        const TraceRecord *begin = nullptr;
+        for(const TraceRecord &record : events[thread]) {
+            switch(record.event) {
+                case TraceEvent::begin:
+                    if(begin) {
+                        fprintf(file, ",\n{\"name\":\"begin\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%zu,\"ts\":", pid, thread);
+                        trace_timestamp(file, begin->time, origin);
+                        fprintf(file, "}");
+                    }
+                    begin = &record;
+                    break;
+                case TraceEvent::read:
+                case TraceEvent::write:
+                    fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"access\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%zu,\"ts\":",
+                        record.event == TraceEvent::read ? "read" : "write", pid, thread);
+                    trace_timestamp(file, record.time, origin);
+                    fprintf(file, ",\"args\":{\"address\":\"%p\",\"size\":%u}}", record.address, record.size);
+                    break;
+                case TraceEvent::commit:
+                case TraceEvent::abort:
+                    fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"transaction\",\"ph\":\"%s\",%s\"pid\":%d,\"tid\":%zu,\"ts\":",
+                        record.event == TraceEvent::commit ? "commit" : "abort", begin ? "X" : "i", begin ? "" : "\"s\":\"t\",", pid, thread);
+                    trace_timestamp(file, begin ? begin->time : record.time, origin);
+                    if(begin) {
+                        uint64_t duration = record.time > begin->time ? record.time - begin->time : 0;
+                        fprintf(file, ",\"dur\":%llu.%03llu", (unsigned long long) (duration / 1000), (unsigned long long) (duration % 1000));
+                    }
+                    fprintf(file, ",\"args\":{");
+                    if(begin) {
+                        fprintf(file, "\"read_only\":%s%s", begin->detail ? "true" : "false", record.event == TraceEvent::abort ? "," : "");
+                    }
+                    if(record.event == TraceEvent::abort) {
+                        fprintf(file, "\"cause\":\"%s\"", trace_cause_name(record.detail));
+                    }
+                    fprintf(file, "}}");
+                    begin = nullptr;
+                    break;
+            }
+        }
+        if(begin) {
+            // Still running, or ended after the copy
+            fprintf(file, ",\n{\"name\":\"begin\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%zu,\"ts\":", pid, thread);
+            trace_timestamp(file, begin->time, origin);
+            fprintf(file, "}");
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
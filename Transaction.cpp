@@ -1,13 +1,167 @@
 #include "Transaction.h"
 #include "macros.h"
 #include "glob_constants.h"
+#include <algorithm>
+#include "Word.h"
 
-void transaction_commit_and_release_locks(Transaction *transaction, VersionSpinLock *ver_wr_spinlocks, size_t align) {
-    Node *node = transaction->writeList->getHead();
-    while(node) {
-        int lock_index = ((uintptr_t) node->address) % LOCK_ARRAY_SIZE;
-        memcpy(node->address, node->val, align);
-        versionSpinLock_set_and_release(&(ver_wr_spinlocks[lock_index]), transaction->wv);
-        node = node->next;
+/**
+ * @brief Per-thread pool of free transaction descriptors, freed when the thread exits.
+ */
+struct TransactionPool {
+    Transaction *free_list = nullptr;
+
+    ~TransactionPool() {
+        while(free_list) {
+            Transaction *next = free_list->next_free;
+            delete free_list;
+            free_list = next;
+        }
+    }
+};
+
+static thread_local TransactionPool transaction_pool;
+
+Transaction *transaction_acquire(bool is_ro, uint64_t clockVersion) {
+    Transaction *transaction = transaction_pool.free_list;
+    if(likely(transaction != nullptr)) {
+        transaction_pool.free_list = transaction->next_free;
+    }
+    else {
+        transaction = new Transaction();
+    }
+
+    transaction->is_ro = is_ro;
+    transaction->rv = clockVersion;
+    transaction->wv = 0;
+    transaction->accesses = 0;
+    transaction->reader_slot = MV_READER_SLOTS;
+    return transaction;
+}
+
+void transaction_release(Transaction *transaction) {
+    transaction->writeSet->reset();
+    transaction->readSet->reset();
+    transaction->readList->reset();
+    transaction->allocated->reset();
+    transaction->freed->reset();
+    transaction->arena->reset();
+    transaction->write_locks = nullptr;
+    transaction->write_lock_count = 0;
+
+    transaction->next_free = transaction_pool.free_list;
+    transaction_pool.free_list = transaction;
+}
+
+Node *transaction_new_node(Transaction *transaction, void *address, void *val, size_t val_size) {
+    if(!val) {
+        return new (transaction->arena->allocate(sizeof(Node))) Node(address, nullptr);
+    }
+
+    // Allocate the node and its value in one go, the value lives right after the node
+    uint8_t *memory = static_cast<uint8_t *>(transaction->arena->allocate(sizeof(Node) + val_size));
+    void *node_val = memory + sizeof(Node);
+    memcpy(node_val, val, val_size);
+    return new (memory) Node(address, node_val);
+}
+
+void transaction_sort_write_locks(Transaction *transaction, Region *region) {
+    size_t *locks = static_cast<size_t *>(transaction->arena->allocate(transaction->writeSet->size() * sizeof(size_t)));
+    size_t count = 0;
+    for(WriteRange *range = transaction->writeSet->getHead(); range; range = range->next) {
+        for(size_t offset = 0; offset < range->size; offset += region->align) {
+            locks[count++] = region->lockIndex(range->address + offset);
+        }
+    }
+    std::sort(locks, locks + count);
+
+    transaction->write_locks = locks;
+    transaction->write_lock_count = std::unique(locks, locks + count) - locks;
+}
+
+bool transaction_has_write_lock(Transaction *transaction, size_t lock_index) {
+    return std::binary_search(transaction->write_locks, transaction->write_locks + transaction->write_lock_count, lock_index);
+}
+
+void *transaction_write_address(Transaction *transaction, Region *region, size_t lock_index) {
+    for(WriteRange *range = transaction->writeSet->getHead(); range; range = range->next) {
+        for(size_t offset = 0; offset < range->size; offset += region->align) {
+            if(region->lockIndex(range->address + offset) == lock_index) {
+                return range->address + offset;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void transaction_release_write_locks(Transaction *transaction, Region *region, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        region->releaseSpinLock(transaction->write_locks[i]);
+    }
+}
+
+/**
+ * @brief Copy the values of the write-set to their target addresses, with words of WordSize bytes.
+ * The generic path copies each range at once, the word stores of the others stay single-copy atomic.
+ */
+template<size_t WordSize>
+static void transaction_write_back_words(Transaction *transaction, Region *region) {
+    for(WriteRange *range = transaction->writeSet->getHead(); range; range = range->next) {
+        if constexpr (WordSize != 0) {
+            for(size_t offset = 0; offset < range->size; offset += WordSize) {
+                word_store<WordSize>(range->address + offset, range->values() + offset, region->align);
+            }
+        }
+        else {
+            memcpy(range->address, range->values(), range->size);
+        }
+    }
+}
+
+void transaction_write_back(Transaction *transaction, Region *region) {
+    switch(region->word_size) {
+        case sizeof(uint64_t):
+            transaction_write_back_words<sizeof(uint64_t)>(transaction, region);
+            break;
+        case sizeof(uint32_t):
+            transaction_write_back_words<sizeof(uint32_t)>(transaction, region);
+            break;
+        default:
+            transaction_write_back_words<0>(transaction, region);
+    }
+}
+
+void transaction_commit_and_release_locks(Transaction *transaction, Region *region) {
+    VersionHistory *history = region->getHistory();
+    bool kept_ahead = false;
+    if(history) {
+        // Save the values about to be overwritten only if a registered read-only transaction may still need them.
+        // The transactions registering later read a clock at least as recent as wv, unless the write version is
+        // ahead of the clock (gv5, gv6): the history of the words must then be marked incomplete, or if it is kept,
+        // the clock is advanced to wv below, otherwise a later snapshot would find the overwritten values
+        bool keep = history->oldestReader() < transaction->wv;
+        bool ahead = region->clock_policy == ClockPolicy::gv5 || region->clock_policy == ClockPolicy::gv6;
+        kept_ahead = keep && ahead;
+        WriteRange *range = keep || ahead ? transaction->writeSet->getHead() : nullptr;
+        for(; range; range = range->next) {
+            for(size_t offset = 0; offset < range->size; offset += region->align) {
+                void *address = range->address + offset;
+                if(keep) {
+                    history->record(region->lockIndex(address), address, transaction->wv);
+                }
+                else {
+                    history->skip(region->lockIndex(address), transaction->wv);
+                }
+            }
+        }
+    }
+
+    transaction_write_back(transaction, region);
+
+    // Words sharing a lock are all written before the lock is released
+    for(size_t i = 0; i < transaction->write_lock_count; i++) {
+        region->setAndReleaseSpinLock(transaction->write_locks[i], transaction->wv);
+    }
+    if(kept_ahead) {
+        region->observeVersion(transaction->wv);
     }
 }
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "VersionHistory.h"
+#include "PageMemory.h"
+#include <string.h>
+
+VersionHistory::VersionHistory(size_t ring_count, unsigned int depth, size_t value_size)
+    : ring_count(ring_count), value_size(value_size), depth(depth) {
+    // Entries are made of the address, the version that overwrote the value, and the value rounded up to 8 bytes
+    entry_size = 2 * sizeof(uint64_t) + ((value_size + 7) & ~(size_t) 7);
+    ring_size = sizeof(RingHeader) + depth * entry_size;
+
+    // Zeroed by the kernel: empty rings, complete since version 0
+    rings = static_cast<uint8_t *>(pageMemory_map(ring_count * ring_size));
+    if(!rings) {
+        throw std::bad_alloc();
+    }
+
+    for(size_t i = 0; i < MV_READER_SLOTS; i++) {
+        readers[i].store(UINT64_MAX);
+    }
+}
+
+VersionHistory::~VersionHistory() {
+    pageMemory_unmap(rings, ring_count * ring_size);
+}
+
+/**
+ * @brief Save the value of a word before a commit overwrites it. The caller holds the lock of the word.
+ * @param index Index of the lock of the word
+ * @param address Address of the word, whose value is still the one to save
+ * @param version Write version of the commit
+ */
+void VersionHistory::record(size_t index, const void *address, uint64_t version) {
+    RingHeader *ring = getRing(index);
+    uint8_t *entry = getEntry(ring, ring->next);
+    uint64_t sequence = ring->sequence.load(std::memory_order_relaxed);
+    ring->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // The entry recycled was the oldest one, the ring only covers the versions after it from now on
+    uint64_t *header = reinterpret_cast<uint64_t *>(entry);
+    if(header[0] != 0 && header[1] > ring->horizon) {
+        ring->horizon = header[1];
+    }
+    header[0] = (uint64_t) (uintptr_t) address;
+    header[1] = version;
+    memcpy(entry + 2 * sizeof(uint64_t), address, value_size);
+    ring->next = (ring->next + 1) % depth;
+
+    ring->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Account for a commit that overwrites a word without saving its value, because no reader needs it.
+ * The caller holds the lock of the word.
+ * @param index Index of the lock of the word
+ * @param version Write version of the commit
+ */
+void VersionHistory::skip(size_t index, uint64_t version) {
+    RingHeader *ring = getRing(index);
+    if(ring->horizon >= version) {
+        return;
+    }
+
+    uint64_t sequence = ring->sequence.load(std::memory_order_relaxed);
+    ring->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->horizon = version;
+    ring->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Find the value a word had at a snapshot, which is the value saved by the first commit after it.
+ * @param index Index of the lock of the word
+ * @param address Address of the word
+ * @param rv Version of the snapshot
+ * @param target Receives the value when it is found in the history
+ * @return Whether the value was found, or is the one in memory, or cannot be known
+ */
+HistoryLookup VersionHistory::lookup(size_t index, const void *address, uint64_t rv, void *target) {
+    RingHeader *ring = getRing(index);
+    uint64_t sequence = ring->sequence.load(std::memory_order_acquire);
+    if(sequence & 0x1 || ring->horizon > rv) {
+        return HistoryLookup::unknown;
+    }
+
+    uint8_t *best = nullptr;
+    uint64_t best_version = UINT64_MAX;
+    for(size_t slot = 0; slot < depth; slot++) {
+        uint8_t *entry = getEntry(ring, slot);
+        uint64_t *header = reinterpret_cast<uint64_t *>(entry);
+        if(header[0] == (uint64_t) (uintptr_t) address && header[1] > rv && header[1] < best_version) {
+            best = entry;
+            best_version = header[1];
+        }
+    }
+    if(best) {
+        memcpy(target, best + 2 * sizeof(uint64_t), value_size);
+    }
+
+    // The entries must all have been read before the sequence is checked again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(ring->sequence.load(std::memory_order_relaxed) != sequence) {
+        return HistoryLookup::unknown;
+    }
+    return best ? HistoryLookup::found : HistoryLookup::current;
+}
+
+/**
+ * @brief Take a slot of the registry for a read-only transaction, before it reads the clock.
+ * The slot holds 0 until the snapshot is published, so that commits keep the history meanwhile.
+ * @return Index of the slot, or MV_READER_SLOTS when all the slots are taken
+ */
+size_t VersionHistory::registerReader() {
+    static thread_local size_t hint = 0;
+    for(size_t i = 0; i < MV_READER_SLOTS; i++) {
+        size_t slot = (hint + i) % MV_READER_SLOTS;
+        uint64_t expected = UINT64_MAX;
+        if(readers[slot].load(std::memory_order_relaxed) == UINT64_MAX && readers[slot].compare_exchange_strong(expected, 0)) {
+            hint = slot;
+            return slot;
+        }
+    }
+    return MV_READER_SLOTS;
+}
+
+/**
+ * @brief Oldest snapshot among the registered read-only transactions
+ * @return The version, UINT64_MAX when there is no reader
+ */
+uint64_t VersionHistory::oldestReader() {
+    uint64_t oldest = UINT64_MAX;
+    for(size_t i = 0; i < MV_READER_SLOTS; i++) {
+        uint64_t rv = readers[i].load();
+        if(rv < oldest) {
+            oldest = rv;
+        }
+    }
+    return oldest;
+}
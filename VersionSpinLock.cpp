@@ -6,7 +6,7 @@ bool versionSpinLock_init(VersionSpinLock* lock) {
 }
 
 bool versionSpinLock_acquire(VersionSpinLock* lock) {
-    int state = lock->lock_state.load();
+    uint64_t state = lock->lock_state.load();
 
     // If the least significant bit is set, lock is taken
     if (state & 1) {
@@ -17,7 +17,12 @@ bool versionSpinLock_acquire(VersionSpinLock* lock) {
     return lock->lock_state.compare_exchange_strong(state, state | 1);
 }
 
-int versionSpinLock_get_state(VersionSpinLock* lock) {
+bool versionSpinLock_acquire_for(VersionSpinLock* lock, uint64_t state, const void *owner) {
+    // The owner is at least 2-byte aligned, so its address leaves room for the lock bit
+    return lock->lock_state.compare_exchange_strong(state, (uint64_t) (uintptr_t) owner | 1);
+}
+
+uint64_t versionSpinLock_get_state(VersionSpinLock* lock) {
     return lock->lock_state.load();
 }
 
@@ -26,7 +31,7 @@ void versionSpinLock_release(VersionSpinLock* lock) {
     lock->lock_state.fetch_sub(1);
 }
 
-void versionSpinLock_set_and_release(VersionSpinLock* lock, int version) {
+void versionSpinLock_set_and_release(VersionSpinLock* lock, uint64_t version) {
     // The version is shifted one bit to the left to avoid overriding the lock bit
     lock->lock_state.store(version << 1);
 }
\ No newline at end of file
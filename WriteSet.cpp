@@ -0,0 +1,226 @@
+#include "WriteSet.h"
+#include <string.h>
+#include "macros.h"
+
+/**
+ * @brief Hash a block into the table
+ * @param block Address of the block shifted by WRITE_SET_BLOCK_SHIFT
+ * @param mask Capacity of the table minus one
+ * @return Index of the first slot to probe
+ */
+static inline size_t writeSet_hash(uintptr_t block, size_t mask) {
+    // Fibonacci hashing, the filter uses the top bits of the same hash
+    return (size_t) ((block * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+WriteSet::WriteSet() : head(nullptr), tail(nullptr), capacity(WRITE_SET_INITIAL_CAPACITY), count(0), words(0), filter{} {
+    table = static_cast<WriteRange **>(calloc(capacity, sizeof(WriteRange *)));
+    if(!table) {
+        throw std::bad_alloc();
+    }
+}
+
+WriteSet::~WriteSet() {
+    free(table);
+}
+
+/**
+ * @brief Double the capacity of the table and re-index all the ranges
+ */
+void WriteSet::grow() {
+    size_t new_capacity = capacity << 1;
+    WriteRange **new_table = static_cast<WriteRange **>(calloc(new_capacity, sizeof(WriteRange *)));
+    if(!new_table) {
+        throw std::bad_alloc();
+    }
+
+    // The entries do not record their block, but the blocks of a range are exactly those its bytes cover
+    for(WriteRange *range = head; range; range = range->next) {
+        uintptr_t last = ((uintptr_t) range->address + range->size - 1) >> WRITE_SET_BLOCK_SHIFT;
+        for(uintptr_t block = (uintptr_t) range->address >> WRITE_SET_BLOCK_SHIFT; block <= last; block++) {
+            size_t index = writeSet_hash(block, new_capacity - 1);
+            while(new_table[index]) {
+                index = (index + 1) & (new_capacity - 1);
+            }
+            new_table[index] = range;
+        }
+    }
+
+    free(table);
+    table = new_table;
+    capacity = new_capacity;
+}
+
+/**
+ * @brief Index a range under a block it covers, the table must have room for the entry
+ * @param range Range to index
+ * @param block Address of the block shifted by WRITE_SET_BLOCK_SHIFT
+ */
+void WriteSet::insert(WriteRange *range, uintptr_t block) {
+    size_t index = writeSet_hash(block, capacity - 1);
+    while(table[index]) {
+        index = (index + 1) & (capacity - 1);
+    }
+    table[index] = range;
+    count++;
+
+    size_t first, second;
+    filterBits(block, &first, &second);
+    filter[first / 64] |= (uint64_t) 1 << (first % 64);
+    filter[second / 64] |= (uint64_t) 1 << (second % 64);
+}
+
+/**
+ * @brief Append words that are not in the write-set yet to the end of a range, which must have room for them
+ * @param range Range to extend
+ * @param source Values of the words
+ * @param size Number of bytes to append, a multiple of the alignment
+ * @param align Size of the words
+ */
+void WriteSet::append(WriteRange *range, const void *source, size_t size, size_t align) {
+    uintptr_t start = (uintptr_t) range->address + range->size;
+    memcpy(range->values() + range->size, source, size);
+
+    // Index the blocks that the range did not cover yet
+    uintptr_t first = start >> WRITE_SET_BLOCK_SHIFT;
+    uintptr_t last = (start + size - 1) >> WRITE_SET_BLOCK_SHIFT;
+    if(range->size != 0 && ((start - 1) >> WRITE_SET_BLOCK_SHIFT) == first) {
+        first++;
+    }
+
+    // Keep the load factor under 1/2 so that probe sequences stay short. The table grows before the range does,
+    // as growing re-indexes the blocks that the ranges cover so far
+    while(unlikely((count + last + 1 - first) * 2 > capacity)) {
+        grow();
+    }
+    for(uintptr_t block = first; block <= last; block++) {
+        insert(range, block);
+    }
+
+    range->size += size;
+    words += size / align;
+}
+
+/**
+ * @brief Buffer the words written to the shared region.
+ * Words already in the write-set are updated in place, the others are appended to the last range
+ * if they follow it, or to a new range sized for the rest of the write.
+ * @param address Target start address in the shared region, aligned
+ * @param source Source start address in private memory
+ * @param size Length to write in bytes, a positive multiple of the alignment
+ * @param align Size of the words, a power of 2
+ * @param arena Arena of the transaction, where the ranges are allocated
+ */
+void WriteSet::write(void *address, const void *source, size_t size, size_t align, Arena *arena) {
+    uint8_t *target = static_cast<uint8_t *>(address);
+    const uint8_t *values = static_cast<const uint8_t *>(source);
+    uintptr_t end = (uintptr_t) target + size;
+
+    size_t i = 0;
+    while(i < size) {
+        uintptr_t word = (uintptr_t) target + i;
+        size_t run;
+        if(!mayContain((void *) word)) {
+            // No word of the block was written, nor of the following blocks that the filter lets through:
+            // the words starting in them are all new
+            uintptr_t run_end = ((word >> WRITE_SET_BLOCK_SHIFT) + 1) << WRITE_SET_BLOCK_SHIFT;
+            while(run_end < end && !mayContainBlock(run_end >> WRITE_SET_BLOCK_SHIFT)) {
+                run_end += (uintptr_t) 1 << WRITE_SET_BLOCK_SHIFT;
+            }
+            run = ((run_end < end ? run_end : end) - word + align - 1) & ~(align - 1);
+        }
+        else {
+            void *value = lookup((void *) word);
+            if(value) {
+                memcpy(value, values + i, align);
+                i += align;
+                continue;
+            }
+            run = align;
+        }
+
+        while(run > 0) {
+            if(!tail || (uintptr_t) tail->address + tail->size != word || tail->size == tail->capacity) {
+                // The capacity stays a multiple of the alignment so that words never straddle two ranges
+                size_t range_capacity = size - i > WRITE_SET_RANGE_MIN_BYTES ? size - i
+                                        : (WRITE_SET_RANGE_MIN_BYTES + align - 1) & ~(align - 1);
+                void *memory = arena->allocate(sizeof(WriteRange) + range_capacity);
+                WriteRange *range = new (memory) WriteRange((uint8_t *) word, range_capacity);
+                if(tail) {
+                    tail->next = range;
+                }
+                else {
+                    head = range;
+                }
+                tail = range;
+            }
+
+            size_t bytes = tail->capacity - tail->size < run ? tail->capacity - tail->size : run;
+            append(tail, values + i, bytes, align);
+            i += bytes;
+            word += bytes;
+            run -= bytes;
+        }
+    }
+}
+
+/**
+ * @brief Search the table for the value of the word with the given address, once the filter let the block through
+ * @param address Address to search for
+ * @return Value of the word in the write-set, or nullptr if not found
+ */
+void *WriteSet::lookup(void *address) {
+    size_t index = writeSet_hash(((uintptr_t) address) >> WRITE_SET_BLOCK_SHIFT, capacity - 1);
+    while(table[index]) {
+        WriteRange *range = table[index];
+        // Also rules out the addresses before the range, as the difference wraps around
+        size_t offset = (uintptr_t) address - (uintptr_t) range->address;
+        if(offset < range->size) {
+            return range->values() + offset;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Empty the write-set, keeping the table for the next transaction unless it grew
+ * beyond WRITE_SET_RETAIN_CAPACITY, in which case it is shrunk back to that capacity.
+ * A kept table is cleared through the blocks of the ranges, so the cost follows the size of the write-set
+ * rather than the capacity of the table. The ranges themselves are released with the arena of the transaction.
+ */
+void WriteSet::reset() {
+    if(head == nullptr) {
+        return;
+    }
+
+    WriteRange **small_table = nullptr;
+    if(unlikely(capacity > WRITE_SET_RETAIN_CAPACITY)) {
+        small_table = static_cast<WriteRange **>(calloc(WRITE_SET_RETAIN_CAPACITY, sizeof(WriteRange *)));
+    }
+
+    if(small_table) {
+        free(table);
+        table = small_table;
+        capacity = WRITE_SET_RETAIN_CAPACITY;
+    }
+    else {
+        // The entry of a block lies in the run of used slots that starts at the slot of its hash. Clearing that run
+        // up to the first free slot clears the entry, unless clearing the run of another block already did
+        for(WriteRange *range = head; range; range = range->next) {
+            uintptr_t last = ((uintptr_t) range->address + range->size - 1) >> WRITE_SET_BLOCK_SHIFT;
+            for(uintptr_t block = (uintptr_t) range->address >> WRITE_SET_BLOCK_SHIFT; block <= last; block++) {
+                for(size_t index = writeSet_hash(block, capacity - 1); table[index]; index = (index + 1) & (capacity - 1)) {
+                    table[index] = nullptr;
+                }
+            }
+        }
+    }
+
+    memset(filter, 0, sizeof(filter));
+    head = nullptr;
+    tail = nullptr;
+    count = 0;
+    words = 0;
+}
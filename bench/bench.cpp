@@ -0,0 +1,858 @@
+/**
+ * @file   bench.cpp
+ *
+ * @section LICENSE
+ *
+ * MIT License
+ *
+ * @section DESCRIPTION
+ *
+ * Multi-threaded benchmark harness. It loads a transactional memory shared
+ * object, drives it only through the tm.hpp C API and reports the commit
+ * throughput, the abort ratio and the latency percentiles of the chosen
+ * workload, for each of the requested thread counts.
+ *
+**/
+
+// External headers
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Internal headers
+#include "tm.hpp"
+#include "tm_ext.hpp"
+#include "Latency.h"
+
+/**
+ * @brief Entry points of the library under test, resolved with dlsym.
+ */
+struct TmApi {
+    shared_t (*create)(size_t, size_t);
+    void     (*destroy)(shared_t);
+    void*    (*start)(shared_t);
+    size_t   (*size)(shared_t);
+    size_t   (*align)(shared_t);
+    tx_t     (*begin)(shared_t, bool);
+    bool     (*end)(shared_t, tx_t);
+    bool     (*read)(shared_t, tx_t, void const*, size_t, void*);
+    bool     (*write)(shared_t, tx_t, void const*, size_t, void*);
+    Alloc    (*alloc)(shared_t, tx_t, size_t, void**);
+    bool     (*free)(shared_t, tx_t, void*);
+    void     (*stats)(shared_t, tm_stats_t*);     // optional extension, nullptr if the library does not export it
+};
+
+/**
+ * @brief Load the library and resolve the API
+ * @param path Path of the shared object
+ * @param api API to fill
+ * @return Whether every symbol was found
+ */
+static bool tmApi_load(const char *path, TmApi *api) {
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if(!handle) {
+        fprintf(stderr, "bench: %s\n", dlerror());
+        return false;
+    }
+
+#define RESOLVE(field, symbol) \
+    if(!(*(void **) &api->field = dlsym(handle, #symbol))) { \
+        fprintf(stderr, "bench: missing symbol " #symbol "\n"); \
+        return false; \
+    }
+    RESOLVE(create, tm_create)
+    RESOLVE(destroy, tm_destroy)
+    RESOLVE(start, tm_start)
+    RESOLVE(size, tm_size)
+    RESOLVE(align, tm_align)
+    RESOLVE(begin, tm_begin)
+    RESOLVE(end, tm_end)
+    RESOLVE(read, tm_read)
+    RESOLVE(write, tm_write)
+    RESOLVE(alloc, tm_alloc)
+    RESOLVE(free, tm_free)
+#undef RESOLVE
+    *(void **) &api->stats = dlsym(handle, "tm_stats");
+
+    return true;
+}
+
+struct Options {
+    const char *library = nullptr;
+    std::string workload = "array";
+    std::vector<int> thread_counts = { 4 };
+    int threads = 4;            // thread count of the current run
+    int duration_ms = 1000;
+    size_t words = 1 << 20;     // number of words in the shared region
+    size_t align = sizeof(uint64_t);    // alignment of the region, the workloads access 8-byte words made of align-byte words
+    int ops = 8;                // words accessed per transaction
+    size_t keys = 1024;         // key range of the set workloads
+    int updates = 20;           // percentage of update transactions of the set and scan workloads
+};
+
+struct ThreadResult {
+    uint64_t commits = 0;
+    uint64_t aborts = 0;
+    LatencyHistogram latencies;     // time from the first attempt to the commit of each transaction
+};
+
+/**
+ * @brief A workload runs transactions until it manages to commit one, counting the aborts on the way.
+ */
+class Workload {
+    public:
+        virtual ~Workload() {}
+
+        virtual size_t regionSize(const Options &options) = 0;
+        virtual bool setup(const TmApi &api, shared_t shared, const Options &options) = 0;
+        virtual void runOne(const TmApi &api, shared_t shared, const Options &options, int thread, std::mt19937_64 &rng, ThreadResult &result) = 0;
+        virtual bool check(const TmApi &, shared_t, const Options &) { return true; }
+};
+
+/**
+ * @brief Read-write transactions on random words of a large array: half of the words are read, the others are
+ * incremented. Real conflicts are rare, so most aborts come from words that share a versioned lock.
+ */
+class ArrayWorkload : public Workload {
+    public:
+        size_t regionSize(const Options &options) override {
+            return options.words * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &, shared_t, const Options &) override {
+            return true;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int, std::mt19937_64 &rng, ThreadResult &result) override {
+            uint64_t *words = static_cast<uint64_t *>(api.start(shared));
+            std::vector<size_t> indices(options.ops);
+
+            // Words are drawn again on retry, as a fixed set of words may never commit
+            // if two of them keep colliding in the lock table
+            for(;;) {
+                for(size_t &index : indices) {
+                    index = rng() % options.words;
+                }
+
+                tx_t tx = api.begin(shared, false);
+                bool alive = tx != invalid_tx;
+                uint64_t sum = 0;
+                for(int i = 0; alive && i < options.ops / 2; i++) {
+                    uint64_t value;
+                    alive = api.read(shared, tx, &words[indices[i]], sizeof(uint64_t), &value);
+                    sum += value;
+                }
+                for(int i = options.ops / 2; alive && i < options.ops; i++) {
+                    alive = api.write(shared, tx, &sum, sizeof(uint64_t), &words[indices[i]]);
+                }
+                if(alive && api.end(shared, tx)) {
+                    result.commits++;
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+};
+
+/**
+ * @brief Write-only transactions where every thread updates its own words, interleaved with the words of the
+ * other threads (thread t owns words t, t + threads, t + 2 * threads...). There is no true conflict, but the
+ * versioned locks of different threads share cache lines unless the lock table is padded.
+ */
+class CountersWorkload : public Workload {
+    public:
+        size_t regionSize(const Options &options) override {
+            return (size_t) options.threads * options.ops * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &, shared_t, const Options &) override {
+            return true;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int thread, std::mt19937_64 &, ThreadResult &result) override {
+            uint64_t *words = static_cast<uint64_t *>(api.start(shared));
+            uint64_t value = result.commits + 1;
+
+            for(;;) {
+                tx_t tx = api.begin(shared, false);
+                bool alive = tx != invalid_tx;
+                for(int i = 0; alive && i < options.ops; i++) {
+                    alive = api.write(shared, tx, &value, sizeof(uint64_t), &words[thread + i * options.threads]);
+                }
+                if(alive && api.end(shared, tx)) {
+                    result.commits++;
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+};
+
+/**
+ * @brief Transfers between random accounts, with read-only audits of the total balance. The total must
+ * never change, so the workload doubles as a consistency stress test.
+ */
+class BankWorkload : public Workload {
+    private:
+        static constexpr uint64_t initial_balance = 100;
+        std::atomic<uint64_t> bad_audits{0};
+
+        /**
+         * @brief Sum all the accounts in one read-only transaction
+         * @return Whether the transaction committed, the sum is stored in total
+         */
+        bool audit(const TmApi &api, shared_t shared, const Options &options, uint64_t *total) {
+            uint64_t *accounts = static_cast<uint64_t *>(api.start(shared));
+            tx_t tx = api.begin(shared, true);
+            if(tx == invalid_tx) {
+                return false;
+            }
+
+            *total = 0;
+            for(size_t i = 0; i < options.words; i++) {
+                uint64_t balance;
+                if(!api.read(shared, tx, &accounts[i], sizeof(uint64_t), &balance)) {
+                    return false;
+                }
+                *total += balance;
+            }
+            return api.end(shared, tx);
+        }
+
+    public:
+        size_t regionSize(const Options &options) override {
+            return options.words * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &api, shared_t shared, const Options &options) override {
+            uint64_t *accounts = static_cast<uint64_t *>(api.start(shared));
+            for(size_t i = 0; i < options.words; i++) {
+                tx_t tx = api.begin(shared, false);
+                if(tx == invalid_tx
+                        || !api.write(shared, tx, &initial_balance, sizeof(uint64_t), &accounts[i])
+                        || !api.end(shared, tx)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int thread, std::mt19937_64 &rng, ThreadResult &result) override {
+            if(thread == 0 && rng() % 64 == 0) {
+                uint64_t total;
+                while(!audit(api, shared, options, &total)) {
+                    result.aborts++;
+                }
+                if(total != options.words * initial_balance) {
+                    bad_audits++;
+                }
+                result.commits++;
+                return;
+            }
+
+            uint64_t *accounts = static_cast<uint64_t *>(api.start(shared));
+            size_t from = rng() % options.words;
+            size_t to = rng() % options.words;
+
+            for(;;) {
+                tx_t tx = api.begin(shared, false);
+                bool alive = tx != invalid_tx;
+                uint64_t from_balance = 0, to_balance = 0;
+                alive = alive && api.read(shared, tx, &accounts[from], sizeof(uint64_t), &from_balance);
+                alive = alive && api.read(shared, tx, &accounts[to], sizeof(uint64_t), &to_balance);
+                if(alive && from != to && from_balance > 0) {
+                    from_balance--;
+                    to_balance++;
+                    alive = api.write(shared, tx, &from_balance, sizeof(uint64_t), &accounts[from])
+                        && api.write(shared, tx, &to_balance, sizeof(uint64_t), &accounts[to]);
+                }
+                if(alive && api.end(shared, tx)) {
+                    result.commits++;
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+
+        bool check(const TmApi &api, shared_t shared, const Options &options) override {
+            uint64_t total;
+            while(!audit(api, shared, options, &total)) {}
+            if(bad_audits.load() > 0 || total != options.words * initial_balance) {
+                fprintf(stderr, "bench: %llu inconsistent audits, final total %llu instead of %llu\n",
+                    (unsigned long long) bad_audits.load(), (unsigned long long) total,
+                    (unsigned long long) (options.words * initial_balance));
+                return false;
+            }
+            return true;
+        }
+};
+
+/**
+ * @brief Microbenchmark of the per-word paths: every transaction reads a block of consecutive words with a
+ * single tm_read, then writes the block back incremented with a single tm_write. Threads work on disjoint
+ * blocks, so the cost measured is the one of the library's word loops and of the commit.
+ */
+class WordsWorkload : public Workload {
+    public:
+        size_t regionSize(const Options &options) override {
+            return (size_t) options.threads * options.ops * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &, shared_t, const Options &) override {
+            return true;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int thread, std::mt19937_64 &, ThreadResult &result) override {
+            uint64_t *block = static_cast<uint64_t *>(api.start(shared)) + (size_t) thread * options.ops;
+            std::vector<uint64_t> values(options.ops);
+
+            for(;;) {
+                tx_t tx = api.begin(shared, false);
+                bool alive = tx != invalid_tx
+                    && api.read(shared, tx, block, options.ops * sizeof(uint64_t), values.data());
+                for(uint64_t &value : values) {
+                    value++;
+                }
+                alive = alive && api.write(shared, tx, values.data(), options.ops * sizeof(uint64_t), block);
+                if(alive && api.end(shared, tx)) {
+                    result.commits++;
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+};
+
+/**
+ * @brief Read-modify-write transactions incrementing random words of a small hot array, visited in random order,
+ * so that committers keep meeting each other's locks. The sum of the words must equal the number of increments
+ * committed.
+ */
+class ContentionWorkload : public Workload {
+    private:
+        std::atomic<uint64_t> increments{0};
+
+    public:
+        size_t regionSize(const Options &options) override {
+            return options.words * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &, shared_t, const Options &) override {
+            return true;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int, std::mt19937_64 &rng, ThreadResult &result) override {
+            uint64_t *words = static_cast<uint64_t *>(api.start(shared));
+            std::vector<size_t> indices(options.ops);
+            for(size_t &index : indices) {
+                index = rng() % options.words;
+            }
+
+            for(;;) {
+                tx_t tx = api.begin(shared, false);
+                bool alive = tx != invalid_tx;
+                for(int i = 0; alive && i < options.ops; i++) {
+                    uint64_t value;
+                    alive = api.read(shared, tx, &words[indices[i]], sizeof(uint64_t), &value);
+                    value++;
+                    alive = alive && api.write(shared, tx, &value, sizeof(uint64_t), &words[indices[i]]);
+                }
+                if(alive && api.end(shared, tx)) {
+                    increments += options.ops;
+                    result.commits++;
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+
+        bool check(const TmApi &api, shared_t shared, const Options &options) override {
+            uint64_t *words = static_cast<uint64_t *>(api.start(shared));
+            uint64_t total = 0;
+            for(;;) {
+                tx_t tx = api.begin(shared, true);
+                bool alive = tx != invalid_tx;
+                total = 0;
+                for(size_t i = 0; alive && i < options.words; i++) {
+                    uint64_t value;
+                    alive = api.read(shared, tx, &words[i], sizeof(uint64_t), &value);
+                    total += value;
+                }
+                if(alive && api.end(shared, tx)) {
+                    break;
+                }
+            }
+            if(total != increments.load()) {
+                fprintf(stderr, "bench: the words sum to %llu instead of %llu\n",
+                    (unsigned long long) total, (unsigned long long) increments.load());
+                return false;
+            }
+            return true;
+        }
+};
+
+/**
+ * @brief Integer set made of sorted singly linked chains of nodes allocated with tm_alloc. A transaction looks up,
+ * inserts or removes a random key, so the nodes are allocated and freed while other threads may be traversing them.
+ * The region holds the pointers to the first node of each chain, and a key goes to the chain chainOf returns.
+ * The chains must stay sorted and hold as many keys as were inserted.
+ */
+class SetWorkload : public Workload {
+    private:
+        std::atomic<int64_t> size{0};
+
+        enum Operation { lookup, insert, remove };
+
+        /**
+         * @brief Walk a chain up to the first node whose key is not lower than key
+         * @param link Receives the address of the pointer to that node
+         * @param node Receives that node, 0 at the end of the chain
+         * @param node_key Receives the key of the node
+         * @return Whether the transaction can continue
+         */
+        static bool find(const TmApi &api, shared_t shared, tx_t tx, uint64_t *head, uint64_t key,
+                uint64_t **link, uint64_t *node, uint64_t *node_key) {
+            *link = head;
+            for(;;) {
+                if(!api.read(shared, tx, *link, sizeof(uint64_t), node)) {
+                    return false;
+                }
+                if(*node == 0) {
+                    return true;
+                }
+                uint64_t *fields = reinterpret_cast<uint64_t *>(*node);
+                if(!api.read(shared, tx, &fields[0], sizeof(uint64_t), node_key)) {
+                    return false;
+                }
+                if(*node_key >= key) {
+                    return true;
+                }
+                *link = &fields[1];
+            }
+        }
+
+        /**
+         * @brief Attempt an operation in one transaction
+         * @param delta Receives the change of the size of the set
+         * @return Whether the transaction committed
+         */
+        bool attempt(const TmApi &api, shared_t shared, const Options &options, Operation operation, uint64_t key, int *delta) {
+            uint64_t *head = static_cast<uint64_t *>(api.start(shared)) + chainOf(options, key);
+            tx_t tx = api.begin(shared, operation == lookup);
+            if(tx == invalid_tx) {
+                return false;
+            }
+
+            uint64_t *link, node, node_key;
+            if(!find(api, shared, tx, head, key, &link, &node, &node_key)) {
+                return false;
+            }
+            bool found = node != 0 && node_key == key;
+
+            *delta = 0;
+            if(operation == insert && !found) {
+                void *memory;
+                Alloc status = api.alloc(shared, tx, 2 * sizeof(uint64_t), &memory);
+                if(status == Alloc::abort) {
+                    return false;
+                }
+                if(status == Alloc::success) {
+                    uint64_t *fields = static_cast<uint64_t *>(memory);
+                    uint64_t new_node = reinterpret_cast<uint64_t>(memory);
+                    if(!api.write(shared, tx, &key, sizeof(uint64_t), &fields[0])
+                            || !api.write(shared, tx, &node, sizeof(uint64_t), &fields[1])
+                            || !api.write(shared, tx, &new_node, sizeof(uint64_t), link)) {
+                        return false;
+                    }
+                    *delta = 1;
+                }
+            }
+            else if(operation == remove && found) {
+                uint64_t *fields = reinterpret_cast<uint64_t *>(node);
+                uint64_t next;
+                if(!api.read(shared, tx, &fields[1], sizeof(uint64_t), &next)
+                        || !api.write(shared, tx, &next, sizeof(uint64_t), link)
+                        || !api.free(shared, tx, fields)) {
+                    return false;
+                }
+                *delta = -1;
+            }
+
+            return api.end(shared, tx);
+        }
+
+    protected:
+        virtual size_t chainCount(const Options &options) = 0;
+        virtual size_t chainOf(const Options &options, uint64_t key) = 0;
+
+    public:
+        size_t regionSize(const Options &options) override {
+            return chainCount(options) * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &api, shared_t shared, const Options &options) override {
+            // Every other key, in decreasing order so that each insertion is at the head of its chain
+            for(uint64_t key = (options.keys - 1) & ~(uint64_t) 1; ; key -= 2) {
+                int delta;
+                while(!attempt(api, shared, options, insert, key, &delta)) {}
+                size += delta;
+                if(key < 2) {
+                    return true;
+                }
+            }
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int, std::mt19937_64 &rng, ThreadResult &result) override {
+            uint64_t key = rng() % options.keys;
+            Operation operation = (int) (rng() % 100) >= options.updates ? lookup : rng() % 2 ? insert : remove;
+
+            int delta;
+            while(!attempt(api, shared, options, operation, key, &delta)) {
+                result.aborts++;
+            }
+            size += delta;
+            result.commits++;
+        }
+
+        bool check(const TmApi &api, shared_t shared, const Options &options) override {
+            uint64_t *heads = static_cast<uint64_t *>(api.start(shared));
+            tx_t tx = api.begin(shared, true);
+            int64_t count = 0;
+            bool sorted = true;
+            for(size_t chain = 0; chain < chainCount(options); chain++) {
+                uint64_t node;
+                bool first = true;
+                uint64_t previous = 0;
+                if(!api.read(shared, tx, &heads[chain], sizeof(uint64_t), &node)) {
+                    fprintf(stderr, "bench: the set could not be traversed\n");
+                    return false;
+                }
+                while(node != 0) {
+                    uint64_t *fields = reinterpret_cast<uint64_t *>(node);
+                    uint64_t key;
+                    if(!api.read(shared, tx, &fields[0], sizeof(uint64_t), &key)
+                            || !api.read(shared, tx, &fields[1], sizeof(uint64_t), &node)) {
+                        fprintf(stderr, "bench: the set could not be traversed\n");
+                        return false;
+                    }
+                    sorted = sorted && (first || key > previous) && chainOf(options, key) == chain;
+                    first = false;
+                    previous = key;
+                    count++;
+                }
+            }
+            api.end(shared, tx);
+
+            if(!sorted || count != size.load()) {
+                fprintf(stderr, "bench: the set holds %lld keys instead of %lld%s\n", (long long) count,
+                    (long long) size.load(), sorted ? "" : ", some chains are not sorted");
+                return false;
+            }
+            return true;
+        }
+};
+
+/**
+ * @brief Sorted linked-list set: a single chain, so every transaction traverses half of the list on average
+ * and the read-sets are long.
+ */
+class ListWorkload : public SetWorkload {
+    protected:
+        size_t chainCount(const Options &) override {
+            return 1;
+        }
+
+        size_t chainOf(const Options &, uint64_t) override {
+            return 0;
+        }
+};
+
+/**
+ * @brief Hash set: one chain per pair of keys, so transactions are short and conflict only on the same chain.
+ */
+class HashSetWorkload : public SetWorkload {
+    protected:
+        size_t chainCount(const Options &options) override {
+            return (options.keys + 1) / 2;
+        }
+
+        size_t chainOf(const Options &options, uint64_t key) override {
+            return (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> 32) % chainCount(options);
+        }
+};
+
+/**
+ * @brief Read-only transactions reading ranges of consecutive words with a single tm_read, while a fraction of
+ * the transactions update random words, which the scans then have to validate against.
+ */
+class ScanWorkload : public Workload {
+    public:
+        size_t regionSize(const Options &options) override {
+            return options.words * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &, shared_t, const Options &options) override {
+            return (size_t) options.ops <= options.words;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &options, int, std::mt19937_64 &rng, ThreadResult &result) override {
+            uint64_t *words = static_cast<uint64_t *>(api.start(shared));
+            bool update = (int) (rng() % 100) < options.updates;
+            size_t first = rng() % (options.words - options.ops + 1);
+            std::vector<uint64_t> values(update ? 1 : options.ops);
+
+            for(;;) {
+                tx_t tx = api.begin(shared, !update);
+                bool alive = tx != invalid_tx;
+                if(update) {
+                    alive = alive && api.read(shared, tx, &words[first], sizeof(uint64_t), values.data());
+                    values[0]++;
+                    alive = alive && api.write(shared, tx, values.data(), sizeof(uint64_t), &words[first]);
+                }
+                else {
+                    alive = alive && api.read(shared, tx, &words[first], options.ops * sizeof(uint64_t), values.data());
+                }
+                if(alive && api.end(shared, tx)) {
+                    result.commits++;
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+};
+
+/**
+ * @brief Each thread increments a word of its own while it keeps a read-only transaction open, then reads the word
+ * back in a new read-only transaction, which begins after the commit returned and must see it. With TM_MV_DEPTH the
+ * open reader makes the commit save the value it overwrites, so a snapshot that does not follow the commit, as with
+ * the write versions ahead of the clock of gv5 and gv6, reads that older value.
+ */
+class SnapshotWorkload : public Workload {
+    private:
+        std::atomic<uint64_t> stale_reads{0};
+
+    public:
+        size_t regionSize(const Options &options) override {
+            return (size_t) options.threads * sizeof(uint64_t);
+        }
+
+        bool setup(const TmApi &, shared_t, const Options &) override {
+            return true;
+        }
+
+        void runOne(const TmApi &api, shared_t shared, const Options &, int thread, std::mt19937_64 &, ThreadResult &result) override {
+            uint64_t *words = static_cast<uint64_t *>(api.start(shared));
+            uint64_t value = result.commits + 1;
+
+            for(;;) {
+                tx_t reader = api.begin(shared, true);
+                if(reader == invalid_tx) {
+                    result.aborts++;
+                    continue;
+                }
+                tx_t tx = api.begin(shared, false);
+                bool committed = tx != invalid_tx && api.write(shared, tx, &value, sizeof(uint64_t), &words[thread])
+                    && api.end(shared, tx);
+                api.end(shared, reader);
+                if(committed) {
+                    break;
+                }
+                result.aborts++;
+            }
+            result.commits++;
+
+            for(;;) {
+                tx_t tx = api.begin(shared, true);
+                uint64_t seen;
+                if(tx != invalid_tx && api.read(shared, tx, &words[thread], sizeof(uint64_t), &seen) && api.end(shared, tx)) {
+                    if(seen != value) {
+                        stale_reads++;
+                    }
+                    return;
+                }
+                result.aborts++;
+            }
+        }
+
+        bool check(const TmApi &, shared_t, const Options &) override {
+            if(stale_reads.load() > 0) {
+                fprintf(stderr, "bench: %llu reads missed a commit that returned before they began\n",
+                    (unsigned long long) stale_reads.load());
+                return false;
+            }
+            return true;
+        }
+};
+
+static Workload *workload_create(const std::string &name) {
+    if(name == "array") return new ArrayWorkload();
+    if(name == "counters") return new CountersWorkload();
+    if(name == "bank") return new BankWorkload();
+    if(name == "contention") return new ContentionWorkload();
+    if(name == "words") return new WordsWorkload();
+    if(name == "list") return new ListWorkload();
+    if(name == "hash") return new HashSetWorkload();
+    if(name == "scan") return new ScanWorkload();
+    if(name == "snapshot") return new SnapshotWorkload();
+    return nullptr;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+        "usage: %s <library.so> [options]\n"
+        "  --workload NAME    array, counters, bank, contention, words, list, hash, scan, snapshot (default array)\n"
+        "  --threads N[,N...] numbers of threads, one run each (default 4)\n"
+        "  --duration MS      duration of the run in milliseconds (default 1000)\n"
+        "  --words N          number of words in the shared region (default 1048576)\n"
+        "  --align N          alignment of the region, 1, 2, 4 or 8 (default 8)\n"
+        "  --ops N            words accessed per transaction, length of the scans (default 8)\n"
+        "  --keys N           key range of the list and hash sets (default 1024)\n"
+        "  --updates PCT      percentage of updates of list, hash and scan (default 20)\n",
+        program);
+}
+
+static bool options_parse(int argc, char **argv, Options *options) {
+    if(argc < 2) {
+        return false;
+    }
+    options->library = argv[1];
+
+    for(int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if(i + 1 >= argc) {
+            return false;
+        }
+        const char *value = argv[++i];
+
+        if(arg == "--workload") options->workload = value;
+        else if(arg == "--threads") {
+            options->thread_counts.clear();
+            for(const char *count = value; *count; ) {
+                char *end;
+                options->thread_counts.push_back((int) strtol(count, &end, 10));
+                if(end == count || options->thread_counts.back() <= 0) return false;
+                count = *end == ',' ? end + 1 : end;
+            }
+        }
+        else if(arg == "--duration") options->duration_ms = atoi(value);
+        else if(arg == "--words") options->words = strtoull(value, nullptr, 10);
+        else if(arg == "--align") options->align = strtoull(value, nullptr, 10);
+        else if(arg == "--ops") options->ops = atoi(value);
+        else if(arg == "--keys") options->keys = strtoull(value, nullptr, 10);
+        else if(arg == "--updates") options->updates = atoi(value);
+        else return false;
+    }
+
+    return !options->thread_counts.empty() && options->duration_ms > 0 && options->words > 0 && options->ops > 0
+        && options->align > 0 && options->align <= sizeof(uint64_t) && (options->align & (options->align - 1)) == 0
+        && options->keys > 0 && options->updates >= 0 && options->updates <= 100;
+}
+
+/**
+ * @brief Run the workload once with options.threads threads on a fresh region and print the results
+ * @return Whether the run completed and the workload found the region consistent
+ */
+static bool bench_run(const TmApi &api, const Options &options) {
+    Workload *workload = workload_create(options.workload);
+    shared_t shared = api.create(workload->regionSize(options), options.align);
+    if(shared == invalid_shared || !workload->setup(api, shared, options)) {
+        fprintf(stderr, "bench: setup failed\n");
+        delete workload;
+        return false;
+    }
+
+    std::atomic<bool> stop(false);
+    std::vector<ThreadResult> results(options.threads);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int t = 0; t < options.threads; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(t + 1);
+            while(!stop.load(std::memory_order_relaxed)) {
+                auto begin = std::chrono::steady_clock::now();
+                workload->runOne(api, shared, options, t, rng, results[t]);
+                results[t].latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.duration_ms));
+    stop.store(true);
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ThreadResult total;
+    for(const ThreadResult &result : results) {
+        total.commits += result.commits;
+        total.aborts += result.aborts;
+        total.latencies.merge(result.latencies);
+    }
+
+    // The statistics of the library are taken before the check, whose transactions are not part of the run
+    tm_stats_t stats;
+    if(api.stats) {
+        api.stats(shared, &stats);
+    }
+
+    bool valid = workload->check(api, shared, options);
+    api.destroy(shared);
+    delete workload;
+
+    double attempts = (double) (total.commits + total.aborts);
+    printf("workload=%s threads=%d commits=%llu commits/s=%.0f abort_ratio=%.4f"
+        " p50_us=%.2f p99_us=%.2f p99.9_us=%.2f max_us=%.2f%s\n",
+        options.workload.c_str(), options.threads, (unsigned long long) total.commits,
+        total.commits / seconds, attempts > 0 ? total.aborts / attempts : 0.0,
+        total.latencies.percentile(0.5) / 1e3, total.latencies.percentile(0.99) / 1e3,
+        total.latencies.percentile(0.999) / 1e3, total.latencies.max() / 1e3,
+        valid ? "" : " INVALID");
+    if(api.stats) {
+        double commits = stats.commits > 0 ? (double) stats.commits : 1.0;
+        printf("  aborts: read_version=%llu validation=%llu lock_busy=%llu no_memory=%llu"
+            " read_set/commit=%.1f write_set/commit=%.1f slot_overflows=%llu\n",
+            (unsigned long long) stats.aborts_read_version, (unsigned long long) stats.aborts_validation,
+            (unsigned long long) stats.aborts_lock_busy, (unsigned long long) stats.aborts_no_memory,
+            stats.read_set_words / commits, stats.write_set_words / commits, (unsigned long long) stats.slot_overflows);
+    }
+    fflush(stdout);
+
+    return valid;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if(!options_parse(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    TmApi api;
+    if(!tmApi_load(options.library, &api)) {
+        return 1;
+    }
+
+    Workload *workload = workload_create(options.workload);
+    if(!workload) {
+        fprintf(stderr, "bench: unknown workload %s\n", options.workload.c_str());
+        return 2;
+    }
+    delete workload;
+
+    bool valid = true;
+    for(int threads : options.thread_counts) {
+        options.threads = threads;
+        valid = bench_run(api, options) && valid;
+    }
+
+    return valid ? 0 : 1;
+}
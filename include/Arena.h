@@ -0,0 +1,60 @@
+#ifndef CS453_2024_PROJECT_MASTER_ARENA_H
+#define CS453_2024_PROJECT_MASTER_ARENA_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <new>
+#include "macros.h"
+
+#define ARENA_INLINE_SIZE 2048
+#define ARENA_MIN_CHUNK_SIZE 16384
+#define ARENA_MAX_CHUNK_SIZE (1 << 20)
+#define ARENA_RETAIN_LIMIT (4 << 20)
+
+/**
+ * @brief Chunk of memory obtained from the system allocator when the inline buffer of the arena is full.
+ */
+struct ArenaChunk {
+    ArenaChunk *next;
+    size_t size;
+    // uint8_t data[] // data of dynamic size
+};
+
+/**
+ * @brief Bump allocator backing the read-set and write-set nodes of a transaction.
+ * Memory is never freed individually, the whole arena is rewound at once with reset().
+ * All the allocations are 8-byte aligned.
+ */
+class Arena {
+    private:
+        uint8_t *cursor;
+        uint8_t *end;
+        ArenaChunk *chunks;     // chunks in use, most recent first
+        ArenaChunk *spare;      // chunks kept from a previous use of the arena
+        size_t next_chunk_size;
+        alignas(16) uint8_t initial[ARENA_INLINE_SIZE];
+
+        void *allocateSlow(size_t size);
+
+    public:
+        Arena();
+        ~Arena();
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        void *allocate(size_t size) {
+            size = (size + 7) & ~((size_t) 7);
+            if(likely((size_t) (end - cursor) >= size)) {
+                void *ptr = cursor;
+                cursor += size;
+                return ptr;
+            }
+            return allocateSlow(size);
+        }
+
+        void reset();
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_ARENA_H
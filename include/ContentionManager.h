@@ -0,0 +1,53 @@
+#ifndef CS453_2024_PROJECT_MASTER_CONTENTIONMANAGER_H
+#define CS453_2024_PROJECT_MASTER_CONTENTIONMANAGER_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include "Region.h"
+#include "Transaction.h"
+
+#define CONTENTION_POLICY_COUNT 5
+
+/**
+ * @brief Names of the contention policies, indexed by ContentionPolicy.
+ */
+extern const char *const contentionManager_policy_names[CONTENTION_POLICY_COUNT];
+
+/**
+ * @brief Called when a transaction starts. Remembers when the first attempt of a transaction started,
+ * and backs off before a new attempt after an abort with the backoff and polka policies.
+ * @param region the region of the transaction
+ * @param transaction the transaction that starts
+ */
+void contentionManager_on_begin(Region *region, Transaction *transaction);
+
+/**
+ * @brief Called when a committing transaction finds one of its write locks taken.
+ * Returns whether it should try to acquire the lock again, after having waited if the policy says so.
+ * @param region the region of the transaction
+ * @param transaction the committing transaction
+ * @param lock_index the index of the taken lock
+ * @param attempt number of failed attempts on this lock so far
+ * @return true to retry the lock, false to abort the transaction
+ */
+bool contentionManager_on_conflict(Region *region, Transaction *transaction, size_t lock_index, unsigned int attempt);
+
+/**
+ * @brief Called once a committing transaction holds a write lock, publishes its priority to the other committers.
+ * @param region the region of the transaction
+ * @param transaction the committing transaction
+ * @param lock_index the index of the acquired lock
+ */
+void contentionManager_on_acquire(Region *region, Transaction *transaction, size_t lock_index);
+
+/**
+ * @brief Called when a transaction commits or aborts.
+ * The work of an aborted attempt is carried over to the next attempt of the calling thread.
+ * @param region the region of the transaction
+ * @param transaction the transaction that ends
+ * @param committed whether the transaction committed
+ */
+void contentionManager_on_end(Region *region, Transaction *transaction, bool committed);
+
+
+#endif //CS453_2024_PROJECT_MASTER_CONTENTIONMANAGER_H
@@ -0,0 +1,40 @@
+#ifndef CS453_2024_PROJECT_MASTER_EPOCHMANAGER_H
+#define CS453_2024_PROJECT_MASTER_EPOCHMANAGER_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include "glob_constants.h"
+#include "SegmentAllocator.h"
+
+/**
+ * @brief Epoch-based reclamation of the segments of a region (Fraser, 2004).
+ * Every transaction announces the global epoch in a slot when it begins, before it reads anything.
+ * A segment freed by a committed transaction, or allocated by an aborted one, is retired in the limbo list
+ * of the current epoch, and the epoch only advances once every running transaction announced it. Two advances
+ * later, no running transaction can have started before the segment was retired, and the segment is given
+ * back to the allocator.
+ * Segments still in limbo when the region is destroyed are released with the slabs of the allocator.
+ */
+class EpochManager {
+    private:
+        SegmentAllocator &allocator;
+        std::atomic<uint64_t> epoch;
+        std::atomic<uint64_t> unannounced;      // transactions running without a slot, they block the epoch
+        std::atomic<uint64_t> slots[EBR_SLOTS];    // epoch announced by the transaction holding the slot, UINT64_MAX when free
+        std::mutex limbo_mutex;
+        segment_node *limbo[3];     // segments retired in each of the last three epochs, by epoch modulo 3
+
+        void tryAdvance();
+
+    public:
+        explicit EpochManager(SegmentAllocator &allocator);
+
+        size_t enter();
+        void exit(size_t slot);
+        void retire(segment_node *segment);
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_EPOCHMANAGER_H
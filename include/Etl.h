@@ -0,0 +1,59 @@
+#ifndef CS453_2024_PROJECT_MASTER_ETL_H
+#define CS453_2024_PROJECT_MASTER_ETL_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include "Region.h"
+#include "Transaction.h"
+
+/**
+ * Encounter-time locking engine (TinySTM, write-through), selected with TM_ENGINE=etl.
+ * A write takes the versioned lock of its word right away, storing the address of the owner transaction
+ * in it, and writes in place. The write-set of the transaction is its undo log: it keeps the value each word had
+ * before the first write of the transaction to it. Reads of words whose lock is owned
+ * by the transaction are plain loads, and conflicts show up at the first access instead of at commit.
+ * Reads are validated against rv as with TL2, and the snapshot is extended when a newer version is met.
+ * Every function returning false has rolled the transaction back, it must then be aborted.
+ */
+
+/**
+ * @brief Read words of the shared region into a private buffer.
+ * @param region the region of the transaction
+ * @param transaction the reading transaction
+ * @param source the address of the first word in the shared region
+ * @param size the number of bytes to read, a multiple of the alignment
+ * @param target the private buffer
+ * @return whether the transaction can continue
+ */
+bool etl_read(Region *region, Transaction *transaction, void const *source, size_t size, void *target);
+
+/**
+ * @brief Lock words of the shared region and write them in place.
+ * @param region the region of the transaction
+ * @param transaction the writing transaction
+ * @param source the private buffer
+ * @param size the number of bytes to write, a multiple of the alignment
+ * @param target the address of the first word in the shared region
+ * @return whether the transaction can continue
+ */
+bool etl_write(Region *region, Transaction *transaction, void const *source, size_t size, void *target);
+
+/**
+ * @brief Restore the words written by the transaction to their values from before it,
+ * and release its locks with a new version. Only for the transactions aborted out of the functions above,
+ * as when they run out of memory.
+ * @param region the region of the transaction
+ * @param transaction the transaction to roll back
+ */
+void etl_rollback(Region *region, Transaction *transaction);
+
+/**
+ * @brief Commit the transaction: validate the read-set if needed, and release the locks with the write version.
+ * @param region the region of the transaction
+ * @param transaction the committing transaction
+ * @return whether the transaction committed
+ */
+bool etl_commit(Region *region, Transaction *transaction);
+
+
+#endif //CS453_2024_PROJECT_MASTER_ETL_H
@@ -0,0 +1,71 @@
+#ifndef CS453_2024_PROJECT_MASTER_HEATMAP_H
+#define CS453_2024_PROJECT_MASTER_HEATMAP_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+#include "glob_constants.h"
+
+/**
+ * @brief Kinds of conflicts recorded per lock.
+ */
+enum class HeatmapEvent {
+    acquire_failure,    // a lock to write was held by another transaction
+    version_failure     // a word read was locked, changed or too recent, or the read-set failed validation
+};
+
+/**
+ * @brief Conflicts sampled on one lock of the table, and the first distinct data addresses they were about.
+ */
+struct HeatmapEntry {
+    size_t lock_index;
+    uint64_t acquire_failures;
+    uint64_t version_failures;
+    const void *addresses[HEATMAP_ADDRESSES];
+    size_t address_count;
+    bool more_addresses;    // other addresses mapped to the lock, the sign of a collision in the lock table
+    bool used;
+};
+
+/**
+ * @brief Lock-table contention heatmap, enabled with TM_HEATMAP. One conflict out of period is sampled on the
+ * failure paths of the transactions and counted against its lock, with the address of the word when it is known.
+ * The entries live in a fixed open-addressed table protected by a mutex: sampling keeps it off the common path,
+ * and the conflicts on new locks are dropped once the table is 3/4 full.
+ */
+class Heatmap {
+    private:
+        const unsigned int period;
+        const std::string file;     // written when the region is destroyed
+        std::mutex mutex;
+        HeatmapEntry *entries;      // HEATMAP_ENTRIES entries
+        size_t used;
+        uint64_t sampled;
+        uint64_t dropped;
+
+    public:
+        Heatmap(unsigned int period, const char *file);
+        ~Heatmap();
+
+        Heatmap(const Heatmap &) = delete;
+        Heatmap &operator=(const Heatmap &) = delete;
+
+        /**
+         * @brief Decide whether the conflict met by the calling thread is to be recorded
+         * @return Whether record must be called
+         */
+        bool sample() {
+            static thread_local uint64_t conflicts = 0;
+            return ++conflicts % period == 0;
+        }
+
+        const char *getFile() { return file.c_str(); }
+
+        void record(HeatmapEvent event, size_t lock_index, const void *address);
+        bool dump(const char *path, size_t lock_count);
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_HEATMAP_H
@@ -0,0 +1,165 @@
+#ifndef CS453_2024_PROJECT_MASTER_LATENCY_H
+#define CS453_2024_PROJECT_MASTER_LATENCY_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include "glob_constants.h"
+
+#define LATENCY_BUCKETS (64 << LATENCY_SUB_BUCKET_BITS)
+
+/**
+ * @brief Durations measured on the timed transactions.
+ */
+enum class LatencyPhase : size_t {
+    commit,             // from tm_begin to the end of a committed transaction
+    abort,              // from tm_begin to the abort
+    commit_phase,       // tm_end of a committed transaction
+    lock_acquisition,   // taking the write locks at commit (tl2), or the sequence lock (norec)
+    validation,         // validating the read-set at commit (tl2 and etl)
+    count
+};
+
+/**
+ * @brief Log-linear histogram of durations in nanoseconds, as in HdrHistogram: 2^LATENCY_SUB_BUCKET_BITS linear
+ * buckets per power of 2, so that any percentile is within 2^-LATENCY_SUB_BUCKET_BITS of its true value.
+ * Histograms merge by adding their buckets.
+ */
+struct LatencyHistogram {
+    std::atomic<uint64_t> counts[LATENCY_BUCKETS];
+    std::atomic<uint64_t> maximum;
+
+    LatencyHistogram() : counts{}, maximum(0) {}
+
+    static size_t bucket(uint64_t ns) {
+        if(ns < (1 << LATENCY_SUB_BUCKET_BITS)) {
+            return ns;
+        }
+        int exponent = 63 - __builtin_clzll(ns);
+        return ((size_t) (exponent - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS)
+            + ((ns >> (exponent - LATENCY_SUB_BUCKET_BITS)) & ((1 << LATENCY_SUB_BUCKET_BITS) - 1));
+    }
+
+    static uint64_t upperBound(size_t bucket) {
+        if(bucket < (1 << LATENCY_SUB_BUCKET_BITS)) {
+            return bucket;
+        }
+        int shift = (int) (bucket >> LATENCY_SUB_BUCKET_BITS) - 1;
+        return (((uint64_t) (bucket & ((1 << LATENCY_SUB_BUCKET_BITS) - 1)) + (1 << LATENCY_SUB_BUCKET_BITS) + 1) << shift) - 1;
+    }
+
+    /**
+     * @brief Count a duration. Like the statistics counters, the buckets are updated with relaxed loads and stores,
+     * and threads sharing the histogram may lose a sample
+     * @param ns Duration in nanoseconds
+     */
+    void record(uint64_t ns) {
+        std::atomic<uint64_t> &count = counts[bucket(ns)];
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if(ns > maximum.load(std::memory_order_relaxed)) {
+            maximum.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Add the samples of another histogram, which may still be recording, to this one
+     * @param other Histogram to add
+     */
+    void merge(const LatencyHistogram &other) {
+        for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            counts[i].store(counts[i].load(std::memory_order_relaxed) + other.counts[i].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+        }
+        uint64_t other_maximum = other.maximum.load(std::memory_order_relaxed);
+        if(other_maximum > maximum.load(std::memory_order_relaxed)) {
+            maximum.store(other_maximum, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t count(size_t bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            sum += count(i);
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Duration under which a fraction of the samples fall
+     * @param fraction Fraction of the samples, between 0 and 1
+     * @return Upper bound of the bucket holding that sample in nanoseconds, 0 if there is no sample
+     */
+    uint64_t percentile(double fraction) const {
+        uint64_t rank = (uint64_t) (fraction * total());
+        uint64_t seen = 0;
+        for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            seen += count(i);
+            if(seen > rank) {
+                return upperBound(i) < max() ? upperBound(i) : max();
+            }
+        }
+        return max();
+    }
+};
+
+/**
+ * @brief Histograms of the threads mapped to one slot.
+ */
+struct alignas(CACHE_LINE_SIZE) LatencySlot {
+    LatencyHistogram histograms[static_cast<size_t>(LatencyPhase::count)];
+
+    void record(LatencyPhase phase, uint64_t ns) { histograms[static_cast<size_t>(phase)].record(ns); }
+};
+
+/**
+ * @brief Latency histograms of a region, enabled with TM_LATENCY. One transaction out of period is timed,
+ * and its durations are recorded in the histograms of the slot of its thread, STATS_SLOTS threads having
+ * one of their own. The slots are merged when the histograms are queried.
+ */
+class Latency {
+    private:
+        const unsigned int period;
+        const std::string file;     // written when the region is destroyed
+        LatencySlot *slots;         // STATS_SLOTS slots, mapped so that the slots never used cost no memory
+
+        void merge(LatencyPhase phase, LatencyHistogram *merged);
+
+    public:
+        Latency(unsigned int period, const char *file);
+        ~Latency();
+
+        Latency(const Latency &) = delete;
+        Latency &operator=(const Latency &) = delete;
+
+        /**
+         * @brief Current time for the measures
+         * @return Time in nanoseconds, from an arbitrary origin
+         */
+        static uint64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        /**
+         * @brief Decide whether the transaction beginning on the calling thread is timed
+         * @return Whether the transaction is timed
+         */
+        bool sample() {
+            static thread_local uint64_t transactions = 0;
+            return ++transactions % period == 0;
+        }
+
+        const char *getFile() { return file.c_str(); }
+
+        LatencySlot *slot();
+        uint64_t percentile(LatencyPhase phase, double fraction);
+        bool dump(const char *path);
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_LATENCY_H
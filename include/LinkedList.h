@@ -3,27 +3,18 @@
 
 #include <stdint.h>
 #include <cstdlib>
-#include <string.h>
 #include "macros.h"
 
+/**
+ * @brief NOrec read log or segment list entry. Nodes live in the arena of their transaction,
+ * the value bytes are allocated right after the node.
+ */
 struct Node {
-     Node(void *address, void *val, size_t val_size)
-        : address(address), val(nullptr), next(nullptr) {
-        if(val) {
-            this->val = new uint8_t[val_size];
-            memcpy(this->val, val, val_size);
-        }
-        else {
-            this->val = nullptr;
-        }
-    }
-
-    ~Node() {
-        delete[] static_cast<uint8_t*>(val);
-    }
-
-    void *address;      // the lock and location address are related so we need to keep only one of them in the read-set.
-    void *val;          // Only used in the write-set
+    Node(void *address, void *val)
+        : address(address), val(val), next(nullptr) {}
+
+    void *address;
+    void *val;
     struct Node* next;
 };
 
@@ -31,15 +22,18 @@ class LinkedList {
     private:
         Node *head;
         Node *tail;
+        size_t count;
 
     public:
         LinkedList();
-        ~LinkedList();
 
         Node *getHead() { return head; }
         Node *getTail() { return tail; }
+        size_t size() { return count; }
 
         void add(Node *node);
+        void push(Node *node);
+        void reset() { head = nullptr; tail = nullptr; count = 0; }   // the nodes are owned by the arena
         // No remove, not necessary in this implementation
         Node *get(void *address);
 };
@@ -0,0 +1,45 @@
+#ifndef CS453_2024_PROJECT_MASTER_NOREC_H
+#define CS453_2024_PROJECT_MASTER_NOREC_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include "Region.h"
+#include "Transaction.h"
+
+/**
+ * NOrec engine (Dalessandro et al., PPoPP 2010), selected with TM_ENGINE=norec.
+ * The clock of the region is a sequence lock, odd while a transaction writes back. A transaction remembers
+ * the even value it started from in rv, and logs the values it reads in its read-set. Whenever the clock
+ * moved, the read-set is validated by comparing the logged values with the memory, and rv is advanced.
+ * Writes are buffered in the write-set as with TL2, there is no metadata per word.
+ */
+
+/**
+ * @brief Wait until no transaction writes back.
+ * @param region the region of the transaction
+ * @return the even value of the clock, to start a transaction from
+ */
+uint64_t norec_snapshot(Region *region);
+
+/**
+ * @brief Read words of the shared region into a private buffer, logging them in the read-set.
+ * @param region the region of the transaction
+ * @param transaction the reading transaction
+ * @param source the address of the first word in the shared region
+ * @param size the number of bytes to read, a multiple of the alignment
+ * @param target the private buffer
+ * @return whether the transaction can continue, it must be aborted otherwise
+ */
+bool norec_read(Region *region, Transaction *transaction, void const *source, size_t size, void *target);
+
+/**
+ * @brief Commit a transaction with a non-empty write-set: take the sequence lock, revalidating the read-set
+ * each time another transaction committed first, and write back.
+ * @param region the region of the transaction
+ * @param transaction the committing transaction
+ * @return whether the transaction committed, it must be aborted otherwise
+ */
+bool norec_commit(Region *region, Transaction *transaction);
+
+
+#endif //CS453_2024_PROJECT_MASTER_NOREC_H
@@ -0,0 +1,25 @@
+#ifndef CS453_2024_PROJECT_MASTER_PAGEMEMORY_H
+#define CS453_2024_PROJECT_MASTER_PAGEMEMORY_H
+
+#include <cstdlib>
+
+// Mappings at least this large are backed by transparent huge pages when available
+#define HUGE_PAGE_SIZE (2 << 20)
+
+/**
+ * @brief Map zero-filled memory straight from the kernel. Pages are only committed when first touched,
+ * so large tables that are sparsely used cost nothing up front.
+ * @param bytes Size of the mapping
+ * @return Start of the mapping, or nullptr on failure
+ */
+void *pageMemory_map(size_t bytes);
+
+/**
+ * @brief Unmap memory obtained with pageMemory_map
+ * @param memory Start of the mapping
+ * @param bytes Size of the mapping, as passed to pageMemory_map
+ */
+void pageMemory_unmap(void *memory, size_t bytes);
+
+
+#endif //CS453_2024_PROJECT_MASTER_PAGEMEMORY_H
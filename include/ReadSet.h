@@ -0,0 +1,61 @@
+#ifndef CS453_2024_PROJECT_MASTER_READSET_H
+#define CS453_2024_PROJECT_MASTER_READSET_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <new>
+#include "macros.h"
+
+#define READ_SET_INITIAL_CAPACITY 64
+#define READ_SET_RETAIN_CAPACITY 65536
+#define READ_SET_FILTER_SIZE 64      // power of 2
+
+/**
+ * @brief Read-set of a transaction, for the engines validating versioned locks.
+ * Only the index of the lock of each word is kept, in a flat array that validation scans in order.
+ * A small direct-mapped filter remembers where recent indices were stored, so that words read again or
+ * sharing a lock with a word just read are mostly not added twice. Duplicates that get past the filter
+ * are only validated twice.
+ */
+class ReadSet {
+    private:
+        size_t *indices;
+        size_t capacity;
+        size_t count;
+        uint32_t filter[READ_SET_FILTER_SIZE];     // position of the last index added in each slot, possibly stale
+
+        void grow();
+
+    public:
+        ReadSet();
+        ~ReadSet();
+
+        ReadSet(const ReadSet &) = delete;
+        ReadSet &operator=(const ReadSet &) = delete;
+
+        const size_t *begin() { return indices; }
+        const size_t *end() { return indices + count; }
+        size_t size() { return count; }
+
+        /**
+         * @brief Add the lock of a word read to the read-set
+         * @param lock_index Index of the lock
+         */
+        void add(size_t lock_index) {
+            // A stale position from an earlier transaction is either out of range or holds an index of this one
+            uint32_t &position = filter[lock_index & (READ_SET_FILTER_SIZE - 1)];
+            if(position < count && indices[position] == lock_index) {
+                return;
+            }
+            if(unlikely(count == capacity)) {
+                grow();
+            }
+            position = (uint32_t) count;
+            indices[count++] = lock_index;
+        }
+
+        void reset();
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_READSET_H
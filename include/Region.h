@@ -2,50 +2,131 @@
 #define CS453_2024_PROJECT_MASTER_REGION_H
 
 #include <mutex>
+#include <stdint.h>
 #include "VersionSpinLock.h"
 #include "glob_constants.h"
-
-/**
- * @brief List of dynamically allocated segments.
- */
-struct segment_node {
-    struct segment_node* prev;
-    struct segment_node* next;
-    // uint8_t segment[] // segment of dynamic size
-};
-
-typedef struct segment_node* segment_list;
+#include "RegionConfig.h"
+#include "VersionHistory.h"
+#include "SegmentAllocator.h"
+#include "EpochManager.h"
+#include "Stats.h"
+#include "Heatmap.h"
+#include "Latency.h"
+#include "Trace.h"
+#include "macros.h"
 
 class Region {
     private:
         void* start;
-        segment_list allocs;
-        VersionSpinLock locks[LOCK_ARRAY_SIZE];
-        std::mutex segmentListMutex;
-        std::atomic_uint clock;
+        VersionSpinLock *locks;
+        size_t lock_mask;       // number of locks minus one
+        std::atomic<uint64_t> clock;   // 64 bits, so that it never wraps around
+        std::atomic<uint64_t> *owner_priorities;    // priority of the last owner of each lock, for the contention manager
+        VersionHistory *history;    // older values of the words, in multi-version mode only
+
+        void release();
 
     public:
         const size_t size;
         const size_t align;
-        std::atomic_uint current_txs = 0;
+        const TmEngine engine;
+        const unsigned int align_shift;     // log2(align)
+        const size_t word_size;     // align if the paths are specialised for it, 0 for the generic paths (see Word.h)
+        const ClockPolicy clock_policy;
+        const ContentionPolicy contention_policy;
+        SegmentAllocator allocator;     // dynamic segments
+        EpochManager epochs;        // reclamation of the freed segments, declared after the allocator it returns them to
+        Stats stats;
+        Heatmap *heatmap;       // sampled conflicts per lock, nullptr unless enabled
+        Latency *latency;       // latency histograms of the timed transactions, nullptr unless enabled
+        Trace *trace;           // events of the last transactions of each thread, nullptr unless enabled
 
 
-        Region(size_t size, size_t align);
+        Region(size_t size, size_t align, const RegionConfig &config);
 
         ~Region();
 
         void* getStart() { return start; }
-        segment_list getAllocs() { return allocs; }
-        void setAllocs(segment_list allocs) { this->allocs = allocs; }
-        void unlockSegmentList() { segmentListMutex.unlock(); }
-        void lockSegmentList() { segmentListMutex.lock(); }
-        int getClockVersion() { return clock.load(); }
-        int incrementClockVersion() { return clock.fetch_add(1) + 1; }
+        uint64_t getClockVersion() { return clock.load(); }
+
+        /**
+         * @brief With NOrec, the clock is a sequence lock which is odd while a transaction writes back.
+         * Take it if it still holds the given even value.
+         * @param version Even value of the clock seen by the transaction
+         * @return Whether the lock was taken
+         */
+        bool tryLockClock(uint64_t version) { return clock.compare_exchange_strong(version, version + 1); }
+        void unlockClock(uint64_t version) { clock.store(version); }
+        uint64_t generateWriteVersion(uint64_t rv, bool *must_validate);
+        uint64_t generateAbortVersion();
+
+        /**
+         * @brief Report a lock version newer than the read version of a transaction that is about to abort.
+         * With the gv5 and gv6 policies the clock lags behind the versions installed by commits, so it is
+         * advanced here, otherwise every new transaction would abort on the same version.
+         * @param version Version read from the lock
+         */
+        void observeVersion(uint64_t version) {
+            if(clock_policy == ClockPolicy::gv5 || clock_policy == ClockPolicy::gv6) {
+                uint64_t current = clock.load();
+                while(current < version && !clock.compare_exchange_weak(current, version)) {}
+            }
+        }
+
+        /**
+         * @brief Map a word address to the index of the versioned lock protecting it.
+         * Addresses are multiples of align, so the alignment bits are dropped before reducing
+         * the word number to the table size, otherwise only 1/align of the locks would be used.
+         * @param address Address of the word
+         * @return Index of the lock in the lock table
+         */
+        size_t lockIndex(const void *address) {
+            uintptr_t word = ((uintptr_t) address) >> align_shift;
+#if OREC_LAYOUT == OREC_LAYOUT_GROUPED
+            // Scramble the group number only, the words of a group keep sharing one cache line of locks
+            uintptr_t group = word / VERSION_SPIN_LOCKS_PER_LINE;
+            group *= 0x9E3779B97F4A7C15ULL;
+            group ^= group >> 32;
+            word = group * VERSION_SPIN_LOCKS_PER_LINE + word % VERSION_SPIN_LOCKS_PER_LINE;
+#elif LOCK_HASH_MIX
+            word *= 0x9E3779B97F4A7C15ULL;
+            word ^= word >> 32;
+#endif
+            return word & lock_mask;
+        }
+
+        size_t getLockCount() { return lock_mask + 1; }
 
         VersionSpinLock* getSpinLocks() { return locks; }
-        int getSpinLockState(int index) { return versionSpinLock_get_state(&locks[index]); }
-        bool acquireSpinLock(int index) { return versionSpinLock_acquire(&locks[index]); }
-        void releaseSpinLock(int index) { versionSpinLock_release(&locks[index]); }
+        uint64_t getSpinLockState(size_t index) { return versionSpinLock_get_state(&locks[index]); }
+        bool acquireSpinLock(size_t index) { return versionSpinLock_acquire(&locks[index]); }
+        bool acquireSpinLockFor(size_t index, uint64_t state, const void *owner) { return versionSpinLock_acquire_for(&locks[index], state, owner); }
+        void releaseSpinLock(size_t index) { versionSpinLock_release(&locks[index]); }
+        void setAndReleaseSpinLock(size_t index, uint64_t version) { versionSpinLock_set_and_release(&locks[index], version); }
+
+        VersionHistory *getHistory() { return history; }
+
+        /**
+         * @brief Whether a conflict on a lock is to be recorded in the heatmap, which must then be done with
+         * heatmap->record. Costs a single test when the heatmap is disabled.
+         */
+        bool sampleConflict() { return unlikely(heatmap != nullptr) && heatmap->sample(); }
+
+        /**
+         * @brief Record a conflict in the heatmap, if it is enabled and the conflict is sampled
+         * @param event Kind of the conflict
+         * @param index Index of the lock
+         * @param address Address of the word involved, nullptr if unknown
+         */
+        void recordConflict(HeatmapEvent event, size_t index, const void *address) {
+            if(sampleConflict()) {
+                heatmap->record(event, index, address);
+            }
+        }
+
+        bool hasOwnerPriorities() { return owner_priorities != nullptr; }
+        uint64_t getOwnerPriority(size_t index) { return owner_priorities[index].load(std::memory_order_relaxed); }
+        void setOwnerPriority(size_t index, uint64_t priority) { owner_priorities[index].store(priority, std::memory_order_relaxed); }
 };
 
 
@@ -0,0 +1,63 @@
+#ifndef CS453_2024_PROJECT_MASTER_REGIONCONFIG_H
+#define CS453_2024_PROJECT_MASTER_REGIONCONFIG_H
+
+#include <cstdlib>
+
+/**
+ * @brief Algorithm used to synchronize the transactions of a region.
+ */
+enum class TmEngine {
+    tl2,    // versioned write locks striped over the words, commit-time locking (TL2)
+    norec,  // a single global sequence lock and value-based validation, no per-word metadata (NOrec)
+    etl     // encounter-time locking and write-through with an undo log (TinySTM)
+};
+
+/**
+ * @brief How committing transactions generate their write version from the global clock (TL2 paper, section 3).
+ */
+enum class ClockPolicy {
+    gv1,    // fetch-and-add on every commit
+    gv4,    // a single CAS, on failure the version installed by the winner is shared ("pass on failure")
+    gv5,    // clock + 1 without writing the clock, which only advances when a transaction aborts on a newer version
+    gv6     // gv1 once every GV6_SAMPLE_PERIOD commits, gv5 otherwise
+};
+
+/**
+ * @brief What a committing transaction does when one of its write locks is taken (see ContentionManager.h).
+ */
+enum class ContentionPolicy {
+    suicide,    // abort right away
+    backoff,    // randomized exponential backoff, before retrying the lock and before restarting after an abort
+    karma,      // wait while its karma (work done, including aborted attempts) beats the one of the owner
+    polka,      // karma, with exponential backoff between the waits
+    greedy      // wait if it started before the owner, abort otherwise
+};
+
+/**
+ * @brief Tunables of a region, fixed at tm_create time.
+ * Each one can be overridden through an environment variable, read when the region is created.
+ */
+struct RegionConfig {
+    TmEngine engine;            // tl2, norec or etl (TM_ENGINE)
+    size_t lock_table_size;     // number of versioned locks, power of 2 (TM_LOCK_TABLE_SIZE)
+    ClockPolicy clock_policy;   // gv1, gv4, gv5 or gv6 (TM_CLOCK)
+    ContentionPolicy contention_policy;     // suicide, backoff, karma, polka or greedy (TM_CONTENTION)
+    unsigned int mv_depth;      // older values kept per lock for the read-only transactions, 0 to disable (TM_MV_DEPTH)
+    unsigned int heatmap_period;    // one conflict out of heatmap_period is sampled per thread, 0 to disable (TM_HEATMAP)
+    const char *heatmap_file;   // where the heatmap is written when the region is destroyed (TM_HEATMAP_FILE)
+    unsigned int latency_period;    // one transaction out of latency_period is timed, 0 to disable (TM_LATENCY)
+    const char *latency_file;   // where the latency histograms are written when the region is destroyed (TM_LATENCY_FILE)
+    size_t trace_events;        // events kept per thread by the transaction trace, 0 to disable (TM_TRACE)
+    const char *trace_file;     // where the trace is written when the region is destroyed (TM_TRACE_FILE)
+};
+
+/**
+ * @brief Build the configuration of a new region from its geometry and the environment.
+ * @param size Size of the first segment of the region
+ * @param align Alignment of the region
+ * @return The configuration to create the region with
+ */
+RegionConfig regionConfig_from_env(size_t size, size_t align);
+
+
+#endif //CS453_2024_PROJECT_MASTER_REGIONCONFIG_H
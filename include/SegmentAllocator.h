@@ -0,0 +1,89 @@
+#ifndef CS453_2024_PROJECT_MASTER_SEGMENTALLOCATOR_H
+#define CS453_2024_PROJECT_MASTER_SEGMENTALLOCATOR_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include "glob_constants.h"
+
+/**
+ * @brief Header placed right before every dynamically allocated segment.
+ */
+struct segment_node {
+    struct segment_node* next;  // link in a free list or a limbo list, while the segment is not in use
+    size_t size_class;
+    // uint8_t segment[] // segment of dynamic size
+};
+
+typedef struct segment_node* segment_list;
+
+/**
+ * @brief Memory mapped by the allocator, carved into blocks of one size class.
+ * The record is stored after the blocks, and memory is the start of the mapping, which may come before the first block.
+ */
+struct AllocatorSlab {
+    AllocatorSlab *next;
+    uint8_t *memory;
+    size_t bytes;       // size of the mapping, record included
+};
+
+/**
+ * @brief Allocator of the dynamic segments of a region.
+ * Segments are rounded up to size classes spaced by a quarter of a power of two, so that at most a fifth of
+ * a block is wasted. Each thread allocates from and frees to its own cache of blocks, which exchanges batches
+ * with the shared free list of the size class when it runs empty or grows too large. Blocks are carved from slabs mapped from the kernel, which are registered in a
+ * lock-free list and only unmapped with the allocator: freed segments are recycled, never given back.
+ */
+class SegmentAllocator {
+    private:
+        struct alignas(64) Cache {
+            std::mutex mutex;       // only taken by other threads when more than ALLOC_CACHES threads allocate
+            segment_list blocks[ALLOC_CLASSES];
+            size_t count[ALLOC_CLASSES];
+        };
+
+        struct alignas(64) SizeClass {
+            std::mutex mutex;
+            segment_list blocks;    // blocks flushed by the caches
+            uint8_t *cursor;        // blocks of the last slab which were never handed out
+            uint8_t *end;
+        };
+
+        const size_t header_size;       // bytes before a segment, a multiple of the alignment ending with its segment_node
+        std::atomic<AllocatorSlab *> slabs;
+        Cache caches[ALLOC_CACHES];
+        SizeClass classes[ALLOC_CLASSES];
+
+        size_t blockSize(size_t size_class);
+        static size_t sizeClass(size_t block);
+        bool refill(Cache &cache, size_t size_class);
+        void flush(Cache &cache, size_t size_class);
+
+    public:
+        explicit SegmentAllocator(size_t align);
+        ~SegmentAllocator();
+
+        SegmentAllocator(const SegmentAllocator &) = delete;
+        SegmentAllocator &operator=(const SegmentAllocator &) = delete;
+
+        segment_list allocate(size_t size);
+        void deallocate(segment_list segment);
+
+        /**
+         * @brief Get the segment following a header
+         * @param segment Header returned by allocate
+         * @return Address of the first byte of the segment
+         */
+        static void *segmentStart(segment_list segment) { return (void *) ((uintptr_t) segment + sizeof(struct segment_node)); }
+
+        /**
+         * @brief Get the header of a segment
+         * @param start Address of the first byte of the segment
+         * @return Header of the segment
+         */
+        static segment_list segmentNode(void *start) { return (segment_list) ((uintptr_t) start - sizeof(struct segment_node)); }
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_SEGMENTALLOCATOR_H
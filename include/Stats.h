@@ -0,0 +1,65 @@
+#ifndef CS453_2024_PROJECT_MASTER_STATS_H
+#define CS453_2024_PROJECT_MASTER_STATS_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <atomic>
+#include "glob_constants.h"
+
+/**
+ * @brief Counters kept by the regions, reported by tm_stats (tm_ext.hpp).
+ * The aborts are split by cause, a transaction records its cause before aborting.
+ */
+enum class StatsCounter : size_t {
+    commits,
+    commits_ro,
+    aborts_read_version,    // a word read was locked, changed while it was read, or newer than a snapshot that could not be extended
+    aborts_validation,      // a word of the read-set changed, found when extending the snapshot or at commit
+    aborts_lock_busy,       // a lock to take was held by another transaction and the contention manager gave up
+    aborts_no_memory,       // the transaction could not allocate its bookkeeping
+    begin_failures,
+    slot_overflows,         // transactions that found no free epoch slot, or no free reader slot in multi-version mode
+    read_set_words,         // sizes of the read-sets of the committed transactions
+    write_set_words,        // sizes of the write-sets of the committed transactions
+    allocs,
+    alloc_failures,
+    frees,
+    count
+};
+
+/**
+ * @brief Counters of the threads mapped to one slot, alone in their cache lines.
+ */
+struct alignas(CACHE_LINE_SIZE) StatsSlot {
+    std::atomic<uint64_t> counters[static_cast<size_t>(StatsCounter::count)];
+
+    /**
+     * @brief Add to a counter. The update is a relaxed load and store rather than an atomic increment,
+     * so it costs no more than a plain increment, but updates may be lost when two threads sharing the slot
+     * update the same counter at the same time.
+     * @param counter Counter to update
+     * @param value Value to add
+     */
+    void add(StatsCounter counter, uint64_t value = 1) {
+        std::atomic<uint64_t> &target = counters[static_cast<size_t>(counter)];
+        target.store(target.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Statistics of a region, always on. Each thread updates the slot it is mapped to, STATS_SLOTS threads
+ * have one of their own, and the slots are only summed up when the statistics are queried.
+ */
+class Stats {
+    private:
+        StatsSlot slots[STATS_SLOTS];
+
+    public:
+        Stats();
+
+        StatsSlot *slot();
+        uint64_t total(StatsCounter counter);
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_STATS_H
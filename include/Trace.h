@@ -0,0 +1,97 @@
+#ifndef CS453_2024_PROJECT_MASTER_TRACE_H
+#define CS453_2024_PROJECT_MASTER_TRACE_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "glob_constants.h"
+
+/**
+ * @brief Events of the lifecycle of a transaction.
+ */
+enum class TraceEvent : uint8_t {
+    begin,      // detail: whether the transaction is read-only
+    read,
+    write,
+    commit,
+    abort       // detail: StatsCounter of the cause
+};
+
+struct TraceRecord {
+    uint64_t time;          // nanoseconds, from the clock of Latency::now
+    const void *address;    // first word read or written
+    uint32_t size;          // bytes read or written
+    TraceEvent event;
+    uint8_t detail;
+};
+
+/**
+ * @brief Ring buffer of the last events of one thread. Only the owner thread records, and publishes each event by
+ * advancing next, so that a dump can copy the buffer while the thread runs and discard what it overwrote meanwhile.
+ */
+struct TraceBuffer {
+    const std::thread::id owner;
+    const uint32_t thread;          // index of the buffer, the thread id in the trace
+    const uint64_t mask;            // capacity - 1, the capacity is a power of 2
+    TraceRecord *records;
+    std::atomic<uint64_t> next;     // events recorded so far
+
+    TraceBuffer(std::thread::id owner, uint32_t thread, uint64_t capacity, TraceRecord *records) :
+        owner(owner), thread(thread), mask(capacity - 1), records(records), next(0) {}
+
+    /**
+     * @brief Record an event, overwriting the oldest one when the buffer is full
+     * @param event Event
+     * @param time Time of the event
+     * @param address Address of the words read or written, nullptr for the other events
+     * @param size Bytes read or written, 0 for the other events
+     * @param detail Detail of the event, see TraceEvent
+     */
+    void record(TraceEvent event, uint64_t time, const void *address, size_t size, uint8_t detail) {
+        uint64_t position = next.load(std::memory_order_relaxed);
+        TraceRecord &entry = records[position & mask];
+        entry.time = time;
+        entry.address = address;
+        entry.size = (uint32_t) size;
+        entry.event = event;
+        entry.detail = detail;
+        next.store(position + 1, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Transaction trace of a region, enabled with TM_TRACE. Each thread records the events of its transactions
+ * in a ring buffer of its own, which keeps the last events of the thread: the buffers are created on the first
+ * transaction of a thread, up to TRACE_THREADS of them, and are written to a file in the Chrome trace_event JSON
+ * format, where a transaction is a slice from its beginning to its commit or abort and its accesses are instants.
+ */
+class Trace {
+    private:
+        const uint64_t id;          // distinguishes the traces for the thread-local buffer cache
+        const uint64_t capacity;    // events per thread
+        const std::string file;     // written when the region is destroyed
+        const uint64_t origin;      // time of creation, the origin of the timestamps
+        std::mutex mutex;
+        std::vector<TraceBuffer *> buffers;     // indexed by the thread id in the trace
+        uint64_t untraced_transactions;     // began on threads without a buffer
+
+    public:
+        Trace(size_t events, const char *file);
+        ~Trace();
+
+        Trace(const Trace &) = delete;
+        Trace &operator=(const Trace &) = delete;
+
+        const char *getFile() { return file.c_str(); }
+
+        TraceBuffer *buffer();
+        bool dump(const char *path);
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_TRACE_H
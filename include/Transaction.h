@@ -5,32 +5,121 @@
 #include <cstdlib>
 #include <stdlib.h>
 #include <string.h>
+#include <memory>
 #include "VersionSpinLock.h"
+#include "Region.h"
 #include "LinkedList.h"
+#include "WriteSet.h"
+#include "ReadSet.h"
+#include "Arena.h"
 
+/**
+ * @brief Transaction descriptor. Descriptors are pooled per thread and reused across transactions,
+ * so the capacity of their sets and arena stays warm. The sets and the arena are owned through unique_ptr,
+ * so those already built are freed if building a later one throws bad_alloc.
+ */
 struct Transaction {
-    Transaction(bool is_ro, int clockVersion) :
-        is_ro(is_ro), writeList(new LinkedList()), readList(new LinkedList()), rv(clockVersion), wv(-1) {}
-
-    ~Transaction() {
-        delete writeList;
-        delete readList;
-    }
+    Transaction() :
+        is_ro(false), writeSet(new WriteSet()), readSet(new ReadSet()), readList(new LinkedList()),
+        allocated(new LinkedList()), freed(new LinkedList()), arena(new Arena()), write_locks(nullptr), write_lock_count(0), rv(0), wv(0), accesses(0),
+        reader_slot(MV_READER_SLOTS), epoch_slot(EBR_SLOTS), stats(nullptr), abort_cause(StatsCounter::aborts_validation),
+        latency(nullptr), begin_time(0), commit_time(0), trace(nullptr), next_free(nullptr) {}
 
     bool is_ro;
-    LinkedList *writeList;
-    LinkedList *readList;
-    int rv;
-    int wv;
+    std::unique_ptr<WriteSet> writeSet;     // values to write at commit (tl2 and norec engines), or undo log (etl engine)
+    std::unique_ptr<ReadSet> readSet;       // locks of the words read (tl2 and etl engines)
+    std::unique_ptr<LinkedList> readList;   // words read and their values (norec engine)
+    std::unique_ptr<LinkedList> allocated;  // segments allocated by the transaction, released if it aborts
+    std::unique_ptr<LinkedList> freed;      // segments freed by the transaction, released if it commits
+    std::unique_ptr<Arena> arena;       // backs the nodes of the sets and their values
+    size_t *write_locks;        // distinct lock indices of the write-set in increasing order, computed at commit (tl2 engine)
+    size_t write_lock_count;
+    uint64_t rv;
+    uint64_t wv;
+    uint64_t accesses;          // words read or written, the work that the karma contention policies weigh
+    size_t reader_slot;         // slot of the read-only transaction in the registry of the history, MV_READER_SLOTS if none
+    size_t epoch_slot;          // slot announcing the epoch of the transaction, EBR_SLOTS if none
+    StatsSlot *stats;           // statistics slot of the thread in the region
+    StatsCounter abort_cause;   // set by the path that makes the transaction abort, before it returns false
+    LatencySlot *latency;       // latency histograms of the thread if the transaction is timed, nullptr otherwise
+    uint64_t begin_time;        // times of tm_begin and of tm_end, for the timed transactions
+    uint64_t commit_time;
+    TraceBuffer *trace;         // trace buffer of the thread if the region is traced, nullptr otherwise
+    Transaction *next_free;     // link in the descriptor pool of the thread
 };
 
 /**
- * @brief Commit the transaction by traversing the writeList, copying the values to the target addresses, and releasing the locks.
+ * @brief Take a descriptor from the pool of the calling thread, or allocate one if the pool is empty.
+ * @param is_ro whether the transaction is read-only
+ * @param clockVersion the read version of the transaction
+ * @return the descriptor, ready to use
+ */
+Transaction *transaction_acquire(bool is_ro, uint64_t clockVersion);
+
+/**
+ * @brief Empty the sets of the transaction and give the descriptor back to the pool of the calling thread.
+ * Must be called on every exit path of the transaction, whether it commits or aborts.
+ * @param transaction the transaction that ended
+ */
+void transaction_release(Transaction *transaction);
+
+/**
+ * @brief Allocate a list node in the arena of the transaction.
+ * @param transaction the transaction owning the node
+ * @param address the address of the word
+ * @param val the value to copy in the node, or nullptr for nodes without a value
+ * @param val_size the size of the value
+ * @return the new node
+ */
+Node *transaction_new_node(Transaction *transaction, void *address, void *val, size_t val_size);
+
+/**
+ * @brief Compute the distinct lock indices of the write-set, in the order in which they are acquired at commit.
+ * Words sharing a lock yield a single index, and acquiring in increasing order prevents two committers from
+ * waiting for each other. The array lives in the arena of the transaction.
+ * @param transaction the committing transaction
+ * @param region the region of the transaction
+ */
+void transaction_sort_write_locks(Transaction *transaction, Region *region);
+
+/**
+ * @brief Check whether a lock is one of the write locks of the transaction, by binary search.
+ * @param transaction the committing transaction, whose write locks are sorted
+ * @param lock_index the index of the lock
+ * @return whether the transaction acquires the lock at commit
+ */
+bool transaction_has_write_lock(Transaction *transaction, size_t lock_index);
+
+/**
+ * @brief Find a word of the write-set protected by a lock, by a linear scan of the write-set.
+ * @param transaction the transaction
+ * @param region the region of the transaction
+ * @param lock_index the index of the lock
+ * @return the address of the first such word, or nullptr if there is none
+ */
+void *transaction_write_address(Transaction *transaction, Region *region, size_t lock_index);
+
+/**
+ * @brief Release the first write locks of the transaction, keeping their versions.
+ * @param transaction the transaction giving up its commit
+ * @param region the region holding the versioned write spinlocks
+ * @param count the number of write locks acquired so far
+ */
+void transaction_release_write_locks(Transaction *transaction, Region *region, size_t count);
+
+/**
+ * @brief Copy the values of the write-set to their target addresses.
+ * @param transaction the committing transaction
+ * @param region the region of the transaction
+ */
+void transaction_write_back(Transaction *transaction, Region *region);
+
+/**
+ * @brief Commit the transaction by traversing the write-set, copying the values to the target addresses, and releasing the locks.
  * @param transaction the transaction to commit
- * @param ver_wr_spinlocks the versioned write spinlocks list
- * @param align the alignment of the memory accesses
+ * @param region the region holding the versioned write spinlocks
  */
-void transaction_commit_and_release_locks(Transaction *transaction, VersionSpinLock *ver_wr_spinlocks, size_t align);
+void transaction_commit_and_release_locks(Transaction *transaction, Region *region);
 
 
 #endif //CS453_2024_PROJECT_MASTER_TRANSACTION_H
@@ -0,0 +1,61 @@
+#ifndef CS453_2024_PROJECT_MASTER_VERSIONHISTORY_H
+#define CS453_2024_PROJECT_MASTER_VERSIONHISTORY_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include "glob_constants.h"
+
+/**
+ * @brief Outcome of a lookup in the history of an orec.
+ */
+enum class HistoryLookup {
+    found,      // the value at the snapshot was copied from the history
+    current,    // the word was not written since the snapshot, the value in memory is the one at the snapshot
+    unknown     // the history is incomplete or was being written, the snapshot cannot be served
+};
+
+/**
+ * @brief Older values of the words, for the read-only transactions of the multi-version mode (TM_MV_DEPTH).
+ * Every versioned lock has a ring of depth entries, each one holding the value a word had before a commit
+ * overwrote it at some version. Committers fill the ring of a lock while they hold it, recycling the oldest
+ * entry, and each ring has its own sequence number so that readers can detect concurrent updates.
+ * Read-only transactions announce their snapshot in a registry, so that commits skip the history while
+ * no active reader is older than them.
+ */
+class VersionHistory {
+    private:
+        struct RingHeader {
+            std::atomic<uint64_t> sequence;     // odd while a committer updates the ring
+            uint64_t horizon;       // every write at a newer version of the words of the lock is in the ring
+            uint64_t next;          // entry to recycle next
+        };
+
+        uint8_t *rings;
+        size_t ring_count;
+        size_t ring_size;           // bytes, header included
+        size_t entry_size;          // bytes, address and version included
+        size_t value_size;
+        unsigned int depth;
+        std::atomic<uint64_t> readers[MV_READER_SLOTS];    // snapshots of the read-only transactions, UINT64_MAX when free
+
+        RingHeader *getRing(size_t index) { return reinterpret_cast<RingHeader *>(rings + index * ring_size); }
+        uint8_t *getEntry(RingHeader *ring, size_t slot) { return reinterpret_cast<uint8_t *>(ring + 1) + slot * entry_size; }
+
+    public:
+        VersionHistory(size_t ring_count, unsigned int depth, size_t value_size);
+        ~VersionHistory();
+
+        void record(size_t index, const void *address, uint64_t version);
+        void skip(size_t index, uint64_t version);
+        HistoryLookup lookup(size_t index, const void *address, uint64_t rv, void *target);
+
+        size_t registerReader();
+        void publishReader(size_t slot, uint64_t rv) { readers[slot].store(rv); }
+        void unregisterReader(size_t slot) { readers[slot].store(UINT64_MAX, std::memory_order_release); }
+        uint64_t oldestReader();
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_VERSIONHISTORY_H
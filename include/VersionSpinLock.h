@@ -4,19 +4,31 @@
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <atomic>
+#include <stdint.h>
+#include "glob_constants.h"
 
-struct VersionSpinLock {
-    std::atomic_int lock_state;
+#if OREC_LAYOUT == OREC_LAYOUT_PADDED
+#define VERSION_SPIN_LOCK_ALIGNMENT CACHE_LINE_SIZE
+#else
+#define VERSION_SPIN_LOCK_ALIGNMENT alignof(std::atomic<uint64_t>)
+#endif
+
+struct alignas(VERSION_SPIN_LOCK_ALIGNMENT) VersionSpinLock {
+    std::atomic<uint64_t> lock_state;     // version << 1 | lock bit, or owner | lock bit with encounter-time locking
 } ;
 
+// Number of versioned locks sharing a cache line in the lock table
+#define VERSION_SPIN_LOCKS_PER_LINE (CACHE_LINE_SIZE / sizeof(VersionSpinLock))
+
 bool versionSpinLock_init(VersionSpinLock* lock);
 
 bool versionSpinLock_acquire(VersionSpinLock* lock);
+bool versionSpinLock_acquire_for(VersionSpinLock* lock, uint64_t state, const void *owner);
 
-int versionSpinLock_get_state(VersionSpinLock* lock);
+uint64_t versionSpinLock_get_state(VersionSpinLock* lock);
 
 void versionSpinLock_release(VersionSpinLock* lock);
 
-void versionSpinLock_set_and_release(VersionSpinLock* lock, int version);
+void versionSpinLock_set_and_release(VersionSpinLock* lock, uint64_t version);
 
 #endif //CS453_2024_PROJECT_MASTER_VERSIONSPINLOCK_H
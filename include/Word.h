@@ -0,0 +1,81 @@
+#ifndef CS453_2024_PROJECT_MASTER_WORD_H
+#define CS453_2024_PROJECT_MASTER_WORD_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <string.h>
+#include "glob_constants.h"
+
+/**
+ * @brief Unsigned integer type of a word of WordSize bytes, void if there is none.
+ */
+template<size_t WordSize> struct WordType { typedef void type; };
+template<> struct WordType<1> { typedef uint8_t type; };
+template<> struct WordType<2> { typedef uint16_t type; };
+template<> struct WordType<4> { typedef uint32_t type; };
+template<> struct WordType<8> { typedef uint64_t type; };
+
+/**
+ * @brief Word size that the paths of a region are specialised for: its alignment when it is a common
+ * word size, or 0 for the generic paths which copy align bytes at a time.
+ * @param align Alignment of the region
+ * @return WordSize template argument
+ */
+static inline size_t word_size_for(size_t align) {
+#if WORD_FAST_PATHS
+    if(align == sizeof(uint64_t) || align == sizeof(uint32_t)) {
+        return align;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Copy a word from the shared region, with a single relaxed atomic load for the common word sizes.
+ * The versioned lock of the word is read before and after, so only the load itself needs to be atomic.
+ * @param target Address of the word in private memory
+ * @param source Address of the word in the shared region
+ * @param align Size of the words, used by the generic path only
+ */
+template<size_t WordSize>
+static inline void word_load(void *target, const void *source, size_t align) {
+    typedef typename WordType<WordSize>::type word_t;
+    if constexpr (WordSize != 0) {
+        *static_cast<word_t *>(target) = __atomic_load_n(static_cast<const word_t *>(source), __ATOMIC_RELAXED);
+    }
+    else {
+        memcpy(target, source, align);
+    }
+}
+
+/**
+ * @brief Copy a word to the shared region, with a single relaxed atomic store for the common word sizes.
+ * The versioned lock of the word is released afterwards with release semantics.
+ * @param target Address of the word in the shared region
+ * @param source Address of the word in private memory
+ * @param align Size of the words, used by the generic path only
+ */
+template<size_t WordSize>
+static inline void word_store(void *target, const void *source, size_t align) {
+    typedef typename WordType<WordSize>::type word_t;
+    if constexpr (WordSize != 0) {
+        __atomic_store_n(static_cast<word_t *>(target), *static_cast<const word_t *>(source), __ATOMIC_RELAXED);
+    }
+    else {
+        memcpy(target, source, align);
+    }
+}
+
+/**
+ * @brief Copy a word between private locations, such as the values of the write-set.
+ * @param target Destination
+ * @param source Source
+ * @param align Size of the words, used by the generic path only
+ */
+template<size_t WordSize>
+static inline void word_copy(void *target, const void *source, size_t align) {
+    memcpy(target, source, WordSize != 0 ? WordSize : align);
+}
+
+
+#endif //CS453_2024_PROJECT_MASTER_WORD_H
@@ -0,0 +1,106 @@
+#ifndef CS453_2024_PROJECT_MASTER_WRITESET_H
+#define CS453_2024_PROJECT_MASTER_WRITESET_H
+
+#include <stdint.h>
+#include <cstdlib>
+#include <new>
+#include "Arena.h"
+
+#define WRITE_SET_INITIAL_CAPACITY 16
+#define WRITE_SET_RETAIN_CAPACITY 4096
+#define WRITE_SET_FILTER_BITS 256        // power of 2, at most 256
+#define WRITE_SET_BLOCK_SHIFT 6          // the ranges are indexed by blocks of 64 bytes
+#define WRITE_SET_RANGE_MIN_BYTES 64     // room left in a new range for the adjacent writes that may follow
+
+/**
+ * @brief Contiguous words written by a transaction, their values are stored right after the range.
+ */
+struct WriteRange {
+    uint8_t *address;
+    size_t size;        // bytes written
+    size_t capacity;    // bytes available for the values
+    WriteRange *next;
+    // uint8_t values[] // values of dynamic size
+
+    WriteRange(uint8_t *address, size_t capacity) : address(address), size(0), capacity(capacity), next(nullptr) {}
+
+    uint8_t *values() { return reinterpret_cast<uint8_t *>(this + 1); }
+};
+
+/**
+ * @brief Write-set of a transaction.
+ * The words written are kept as ranges of contiguous words in insertion order, which is the order used at commit:
+ * a write adjacent to the end of the last range extends it, so bulk writes cost one entry and are written back
+ * with one copy. The ranges are indexed by an open-addressed hash table with an entry per block of
+ * 2^WRITE_SET_BLOCK_SHIFT bytes covered by each range, for O(1) expected lookups.
+ * A Bloom filter over the blocks (two bits each) answers most lookups of words that were not written,
+ * which are the common case of the reads, without probing the table.
+ */
+class WriteSet {
+    private:
+        WriteRange *head;
+        WriteRange *tail;
+        WriteRange **table;     // linear probing, capacity is always a power of 2
+        size_t capacity;
+        size_t count;           // entries of the table
+        size_t words;
+        uint64_t filter[WRITE_SET_FILTER_BITS / 64];
+
+        void grow();
+        void insert(WriteRange *range, uintptr_t block);
+        void append(WriteRange *range, const void *source, size_t size, size_t align);
+        void *lookup(void *address);
+
+        /**
+         * @brief Derive the two filter bits of a block from the top bits of a Fibonacci hash
+         * @param block Address of the block shifted by WRITE_SET_BLOCK_SHIFT
+         * @param first Receives the index of the first bit
+         * @param second Receives the index of the second bit
+         */
+        static void filterBits(uintptr_t block, size_t *first, size_t *second) {
+            uint64_t hash = block * 0x9E3779B97F4A7C15ULL;
+            *first = (hash >> 56) & (WRITE_SET_FILTER_BITS - 1);
+            *second = (hash >> 48) & (WRITE_SET_FILTER_BITS - 1);
+        }
+
+        bool mayContainBlock(uintptr_t block) {
+            size_t first, second;
+            filterBits(block, &first, &second);
+            return (filter[first / 64] >> (first % 64)) & (filter[second / 64] >> (second % 64)) & 1;
+        }
+
+    public:
+        WriteSet();
+        ~WriteSet();
+
+        WriteSet(const WriteSet &) = delete;
+        WriteSet &operator=(const WriteSet &) = delete;
+
+        WriteRange *getHead() { return head; }
+        size_t size() { return words; }
+
+        void write(void *address, const void *source, size_t size, size_t align, Arena *arena);
+
+        /**
+         * @brief Check whether an address may be in the write-set
+         * @param address Address to search for
+         * @return false if the address is certainly not in the write-set
+         */
+        bool mayContain(void *address) {
+            return mayContainBlock(((uintptr_t) address) >> WRITE_SET_BLOCK_SHIFT);
+        }
+
+        /**
+         * @brief Get the value written to the word with the given address
+         * @param address Address to search for
+         * @return Value of the word in the write-set, or nullptr if not found
+         */
+        void *get(void *address) {
+            return mayContain(address) ? lookup(address) : nullptr;
+        }
+
+        void reset();
+};
+
+
+#endif //CS453_2024_PROJECT_MASTER_WRITESET_H
@@ -1,8 +1,89 @@
 #ifndef CS453_2024_PROJECT_MASTER_GLOB_CONSTANTS_H
 #define CS453_2024_PROJECT_MASTER_GLOB_CONSTANTS_H
 
-#define LOCK_ARRAY_SIZE 65536
+// Bounds of the automatically sized lock table, in number of locks (powers of 2)
+#define LOCK_TABLE_MIN_SIZE 65536
+#define LOCK_TABLE_MAX_SIZE (1 << 26)
 
-#define MAX_SIMUL_TXS 6
+// Scramble the word number before indexing the lock table (1), instead of using its low bits (0)
+#ifndef LOCK_HASH_MIX
+#define LOCK_HASH_MIX 0
+#endif
+
+// Contention manager: a committing transaction gives up on a taken lock after CM_MAX_ATTEMPTS retries,
+// waiting between CM_BACKOFF_MIN_SPINS and CM_BACKOFF_MAX_SPINS pause instructions between two retries
+#ifndef CM_MAX_ATTEMPTS
+#define CM_MAX_ATTEMPTS 8
+#endif
+#define CM_BACKOFF_MIN_SPINS 16
+#ifndef CM_BACKOFF_MAX_SPINS
+#define CM_BACKOFF_MAX_SPINS 256
+#endif
+
+// NOrec: a transaction waiting for a writer to release the sequence lock yields every NOREC_SPINS_BEFORE_YIELD checks
+#define NOREC_SPINS_BEFORE_YIELD 64
+
+// Multi-version mode: at most MV_MAX_DEPTH older values per lock, and MV_READER_SLOTS read-only
+// transactions announcing their snapshot at a time (the others are served only while the history lasts)
+#define MV_MAX_DEPTH 64
+#define MV_READER_SLOTS 64
+// A registered read-only transaction meeting a taken lock yields up to MV_LOCKED_READ_ATTEMPTS times before giving up
+#define MV_LOCKED_READ_ATTEMPTS 8
+
+// Epoch-based reclamation: EBR_SLOTS transactions announce their epoch at a time, the others block reclamation
+#define EBR_SLOTS 128
+
+// Segment allocator: sizes are rounded up to size classes, header included, from 2^ALLOC_MIN_CLASS_SHIFT bytes
+// with four classes per power of two. ALLOC_CACHES threads get a cache of their own, which holds at most
+// ALLOC_CACHE_BYTES per size class
+#define ALLOC_CLASSES 128
+#define ALLOC_MIN_CLASS_SHIFT 5
+#define ALLOC_CACHES 64
+#define ALLOC_CACHE_BYTES (64 << 10)
+#define ALLOC_SLAB_SIZE (256 << 10)
+
+// Statistics: STATS_SLOTS threads update counters of their own, the others share them
+#define STATS_SLOTS 64
+
+// Contention heatmap (TM_HEATMAP): conflicts are counted for at most HEATMAP_ENTRIES * 3/4 locks (power of 2),
+// with up to HEATMAP_ADDRESSES distinct data addresses each
+#define HEATMAP_ENTRIES 4096
+#define HEATMAP_ADDRESSES 4
+
+// Latency histograms (TM_LATENCY): 2^LATENCY_SUB_BUCKET_BITS buckets per power of 2 of nanoseconds
+#define LATENCY_SUB_BUCKET_BITS 4
+
+// Transaction trace (TM_TRACE): threads beyond the first TRACE_THREADS of a region are not traced
+#define TRACE_THREADS 256
+#define TRACE_MAX_EVENTS (1 << 24)     // events kept per thread, at most
+
+// With the gv6 clock policy, one commit out of GV6_SAMPLE_PERIOD increments the clock
+#define GV6_SAMPLE_PERIOD 32
+
+// First value of the global version clock, only meant to be raised for stress tests
+#ifndef CLOCK_INITIAL_VERSION
+#define CLOCK_INITIAL_VERSION 0
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+// Layout of the versioned locks in the lock table, chosen at build time with -DOREC_LAYOUT=...
+//  - PACKED:  locks are stored contiguously, adjacent words map to adjacent locks
+//  - PADDED:  every lock sits alone in its cache line, no false sharing between locks
+//  - GROUPED: locks are stored contiguously, the words are hashed by groups of one cache line
+//             of locks, so adjacent words share a line while distant groups are scattered
+#define OREC_LAYOUT_PACKED 0
+#define OREC_LAYOUT_PADDED 1
+#define OREC_LAYOUT_GROUPED 2
+
+#ifndef OREC_LAYOUT
+#define OREC_LAYOUT OREC_LAYOUT_PACKED
+#endif
+
+// Regions aligned on 4 or 8 bytes use read, write and write-back paths specialised for their word size,
+// which copy words with single atomic accesses. Build with -DWORD_FAST_PATHS=0 to compare with the generic paths
+#ifndef WORD_FAST_PATHS
+#define WORD_FAST_PATHS 1
+#endif
 
 #endif //CS453_2024_PROJECT_MASTER_GLOB_CONSTANTS_H
@@ -0,0 +1,60 @@
+/**
+ * @file   tm_ext.hpp
+ * @author Luis Bustamante Martin-Ibanez
+ *
+ * @section LICENSE
+ *
+ * MIT License
+ *
+ * @section DESCRIPTION
+ *
+ * Extensions to the interface of tm.hpp, specific to this implementation.
+ * They are exported from the same shared object.
+**/
+
+#pragma once
+
+#include "tm.hpp"
+
+// -------------------------------------------------------------------------- //
+
+/**
+ * Statistics of a shared memory region, summed over its threads by tm_stats.
+ * The aborts are split by cause, the set sizes are summed over the committed transactions.
+**/
+struct tm_stats_t {
+    uint64_t commits;               // committed transactions, read-only ones included
+    uint64_t commits_ro;            // committed read-only transactions
+    uint64_t aborts;                // sum of the aborts below
+    uint64_t aborts_read_version;   // a word read was locked, changed while it was read, or newer than a snapshot that could not be extended
+    uint64_t aborts_validation;     // a word of the read-set changed, found when extending the snapshot or at commit
+    uint64_t aborts_lock_busy;      // a lock to take was held by another transaction, and the contention manager gave up
+    uint64_t aborts_no_memory;      // the transaction could not allocate its bookkeeping
+    uint64_t begin_failures;        // calls to tm_begin that returned invalid_tx
+    uint64_t slot_overflows;        // transactions that found no free epoch slot, or no free reader slot in multi-version mode
+    uint64_t read_set_words;        // words in the read-sets (values in the read logs with norec)
+    uint64_t write_set_words;       // words in the write-sets, the undo logs with etl
+    uint64_t allocs;                // successful calls to tm_alloc, in transactions that may have aborted since
+    uint64_t alloc_failures;        // calls to tm_alloc that returned nomem
+    uint64_t frees;                 // calls to tm_free, in transactions that may have aborted since
+};
+
+/**
+ * Durations measured on the transactions timed when TM_LATENCY is set, in the order of LatencyPhase (Latency.h).
+**/
+enum class TmLatency: int {
+    commit           = 0, // from tm_begin to the end of a committed transaction
+    abort            = 1, // from tm_begin to the abort
+    commit_phase     = 2, // tm_end of a committed transaction
+    lock_acquisition = 3, // taking the write locks at commit (tl2), or the sequence lock (norec)
+    validation       = 4  // validating the read-set at commit (tl2 and etl)
+};
+
+extern "C" {
+    const char* tm_contention_policy(shared_t) noexcept;
+    void        tm_stats(shared_t, tm_stats_t*) noexcept;
+    bool        tm_heatmap_dump(shared_t, const char*) noexcept;
+    uint64_t    tm_latency_percentile(shared_t, TmLatency, double) noexcept;
+    bool        tm_latency_dump(shared_t, const char*) noexcept;
+    bool        tm_trace_dump(shared_t, const char*) noexcept;
+}
@@ -8,7 +8,9 @@
  *
  * @section DESCRIPTION
  *
- * Implementation of TL2-like transactional memory.
+ * Implementation of TL2-like transactional memory,
+ * with NOrec and encounter-time locking as alternative engines
+ * (see Norec.h and Etl.h).
  * Some of the comments that explain the code are
  * taken from the reference implementation paper.
  *
@@ -22,26 +24,321 @@
 #include <stdint.h>
 #include <memory>
 #include <string.h>
-#include <cstdlib>
+#include <thread>
 
 // Internal headers
 #include "tm.hpp"
+#include "tm_ext.hpp"
 #include "macros.h"
 #include "Region.h"
+#include "RegionConfig.h"
 #include "VersionSpinLock.h"
 #include "glob_constants.h"
 #include "Transaction.h"
 #include "LinkedList.h"
+#include "WriteSet.h"
+#include "ContentionManager.h"
+#include "Word.h"
+#include "Norec.h"
+#include "Etl.h"
+#include "VersionHistory.h"
+
+
+/** Withdraw the snapshot of a read-only transaction from the registry of the history, if it was announced.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction that ends
+**/
+static void tm_unregister_reader(Region* region, Transaction* transaction) noexcept {
+    if(transaction->reader_slot != MV_READER_SLOTS) {
+        region->getHistory()->unregisterReader(transaction->reader_slot);
+    }
+}
+
+/** Abort the given transaction: the contention manager accounts for the wasted work and the descriptor is recycled.
+ * The segments allocated by the transaction are released, other transactions may have seen them with the etl engine.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction to abort, which must not hold any lock, with its abort cause set
+ * @return false, to be returned as is by the caller
+**/
+static bool tm_abort(Region* region, Transaction* transaction) noexcept {
+    transaction->stats->add(transaction->abort_cause);
+    if(transaction->trace) {
+        transaction->trace->record(TraceEvent::abort, Latency::now(), nullptr, 0, (uint8_t) transaction->abort_cause);
+    }
+    if(transaction->latency) {
+        transaction->latency->record(LatencyPhase::abort, Latency::now() - transaction->begin_time);
+    }
+    tm_unregister_reader(region, transaction);
+    region->epochs.exit(transaction->epoch_slot);
+    for(Node *node = transaction->allocated->getHead(); node; node = node->next) {
+        region->epochs.retire((segment_list) node->address);
+    }
+
+    contentionManager_on_end(region, transaction, false);
+    transaction_release(transaction);
+    return false;
+}
+
+/** Abort the given transaction because it ran out of memory, which only happens in the middle of an operation.
+ * With the etl engine, the words it wrote are restored and its locks released first.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction to abort
+ * @return false, to be returned as is by the caller
+**/
+static bool tm_abort_no_memory(Region* region, Transaction* transaction) noexcept {
+    transaction->abort_cause = StatsCounter::aborts_no_memory;
+    if(region->engine == TmEngine::etl) {
+        etl_rollback(region, transaction);
+    }
+    return tm_abort(region, transaction);
+}
+
+/** End the given committed transaction: the segments it freed are released and the descriptor is recycled.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction that committed, which must not hold any lock
+ * @return true, to be returned as is by the caller
+**/
+static bool tm_committed(Region* region, Transaction* transaction) noexcept {
+    StatsSlot *stats = transaction->stats;
+    stats->add(StatsCounter::commits);
+    if(transaction->trace) {
+        transaction->trace->record(TraceEvent::commit, Latency::now(), nullptr, 0, 0);
+    }
+    if(transaction->is_ro) {
+        stats->add(StatsCounter::commits_ro);
+    }
+    stats->add(StatsCounter::read_set_words,
+        region->engine == TmEngine::norec ? transaction->readList->size() : transaction->readSet->size());
+    stats->add(StatsCounter::write_set_words, transaction->writeSet->size());
+    if(transaction->latency) {
+        uint64_t now = Latency::now();
+        transaction->latency->record(LatencyPhase::commit, now - transaction->begin_time);
+        transaction->latency->record(LatencyPhase::commit_phase, now - transaction->commit_time);
+    }
+
+    tm_unregister_reader(region, transaction);
+    region->epochs.exit(transaction->epoch_slot);
+    if(transaction->freed->getHead()) {
+        // The transactions beginning from now on must see the commit: with gv5 and gv6 the clock may lag behind wv,
+        // and a lagging snapshot could still reach the freed segments
+        region->observeVersion(transaction->wv);
+        for(Node *node = transaction->freed->getHead(); node; node = node->next) {
+            region->epochs.retire((segment_list) node->address);
+        }
+    }
+
+    contentionManager_on_end(region, transaction, true);
+    transaction_release(transaction);
+    return true;
+}
+
+/** Extend the snapshot of a transaction that read a version newer than its read version (LSA).
+ * The read version is advanced to the current clock if no word of the read-set changed since the
+ * transaction started, so that the transaction can go on instead of aborting.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction that read the version
+ * @param lock_index  Index of the lock of the word read
+ * @param lock_state  State of the lock when the word was read, unlocked
+ * @return Whether the snapshot of the transaction now includes the word read
+**/
+static bool tm_extend(Region* region, Transaction* transaction, size_t lock_index, uint64_t lock_state) noexcept {
+    // Under gv5 and gv6 the clock may lag behind the versions written by the commits
+    uint64_t version = lock_state >> 0x1;
+    region->observeVersion(version);
+    uint64_t rv = region->getClockVersion();
+    if(version > rv) {
+        transaction->abort_cause = StatsCounter::aborts_read_version;
+        return false;
+    }
+
+    for(size_t read_lock_index : *transaction->readSet) {
+        uint64_t read_lock_state = region->getSpinLockState(read_lock_index);
+        if(read_lock_state >> 0x1 > transaction->rv || read_lock_state & 0x1) {
+            transaction->abort_cause = StatsCounter::aborts_validation;
+            region->recordConflict(HeatmapEvent::version_failure, read_lock_index, nullptr);
+            return false;
+        }
+    }
 
+    // The word read is not in the read-set yet. A committer that took its lock after it was read may share
+    // the new read version (gv4, gv5, gv6), and its write would then go unnoticed by the later validations
+    if(region->getSpinLockState(lock_index) != lock_state) {
+        transaction->abort_cause = StatsCounter::aborts_read_version;
+        return false;
+    }
+
+    transaction->rv = rv;
+    if(transaction->reader_slot != MV_READER_SLOTS) {
+        region->getHistory()->publishReader(transaction->reader_slot, rv);
+    }
+    return true;
+}
+
+/** Read a word in a read-only transaction.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Read-only transaction
+ * @param source      Address of the word in the shared region
+ * @param target      Address of the word in a private region
+ * @return Whether the value at the snapshot of the transaction was read, the transaction must be aborted otherwise
+**/
+template<size_t WordSize>
+static bool tm_read_ro_word(Region* region, Transaction* transaction, void* source, void* target) noexcept {
+    size_t lock_index = region->lockIndex(source);
+    for(unsigned int attempt = 0; ; attempt++) {
+
+        // Speculative execution
+        uint64_t pre_lock_status = region->getSpinLockState(lock_index);
+        word_load<WordSize>(target, source, region->align);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t post_lock_status = region->getSpinLockState(lock_index);
+
+        // The value read is consistent if the lock did not change and was not taken
+        bool consistent = pre_lock_status == post_lock_status && !(post_lock_status & 0x1);
+        if(consistent && post_lock_status >> 0x1 <= transaction->rv) {
+            return true;
+        }
+
+        // Otherwise, in multi-version mode, the value at the snapshot may be in the history. The value in memory
+        // only is the one at the snapshot if it was read consistently: a committer holding the lock may have a
+        // write version older than rv and not have written back yet
+        if(transaction->reader_slot != MV_READER_SLOTS) {
+            HistoryLookup lookup = region->getHistory()->lookup(lock_index, source, transaction->rv, target);
+            if(lookup == HistoryLookup::found || (lookup == HistoryLookup::current && consistent)) {
+                return true;
+            }
+
+            // Rather than aborting, wait for the committer to save the value or to release the lock
+            if(post_lock_status & 0x1 && attempt < MV_LOCKED_READ_ATTEMPTS) {
+                std::this_thread::yield();
+                continue;
+            }
+        }
+
+        // Or else the snapshot must be extended
+        if(!consistent) {
+            transaction->abort_cause = StatsCounter::aborts_read_version;
+        }
+        if(!consistent || !tm_extend(region, transaction, lock_index, post_lock_status)) {
+            region->observeVersion(post_lock_status >> 0x1);
+            if(transaction->abort_cause == StatsCounter::aborts_read_version) {
+                region->recordConflict(HeatmapEvent::version_failure, lock_index, source);
+            }
+            return false;
+        }
+        return true;
+    }
+}
+
+/** Read words in a read-only or read-write transaction of the tl2 engine.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction to use
+ * @param source      Source start address (in the shared region)
+ * @param size        Length to copy (in bytes), must be a positive multiple of the alignment
+ * @param target      Target start address (in a private region)
+ * @return Whether the whole transaction can continue
+ * @throw std::bad_alloc if the read-set cannot grow, the transaction must then be aborted
+**/
+template<size_t WordSize>
+static bool tm_read_words(Region* region, Transaction* transaction, void const* source, size_t size, void* target) {
+    // The size of the words is a constant in the paths specialised for the common alignments
+    const size_t align = WordSize != 0 ? WordSize : region->align;
+
+    if(transaction->is_ro) {
+        for(size_t i = 0; i < size; i += align) {
+            uintptr_t source_word_add = (uintptr_t) source + i;
+            uintptr_t target_word_add = (uintptr_t) target + i;
+            if(!tm_read_ro_word<WordSize>(region, transaction, (void *) source_word_add, (void *) target_word_add)) {
+                return tm_abort(region, transaction);
+            }
+
+            // Add the lock to the read-set, to be able to extend the snapshot later on.
+            // Once a word was read from the history, its version prevents any extension
+            transaction->readSet->add(region->lockIndex((void *) source_word_add));
+        }
+    }
+    else {
+        for(size_t i = 0; i < size; i += align) {
+            uintptr_t source_word_add = (uintptr_t) source + i;
+            uintptr_t target_word_add = (uintptr_t) target + i;
+
+            // see if the load address already appears in the write-set.
+            void *value = transaction->writeSet->get((void *) source_word_add);
+            if(value) {
+                word_copy<WordSize>((void *) target_word_add, value, align);
+                continue;
+            }
+            else {
+                size_t lock_index = region->lockIndex((void *) source_word_add);
+
+                // Speculative execution
+                uint64_t pre_lock_status = region->getSpinLockState(lock_index);
+                word_load<WordSize>((void *) target_word_add, (void *) source_word_add, align);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t post_lock_status = region->getSpinLockState(lock_index);
+
+                // Check if the lock has changed or if the lock is taken
+                if (pre_lock_status != post_lock_status || post_lock_status & 0x1) {
+
+                    // Abort the transaction
+                    region->observeVersion(post_lock_status >> 0x1);
+                    transaction->abort_cause = StatsCounter::aborts_read_version;
+                    region->recordConflict(HeatmapEvent::version_failure, lock_index, (void *) source_word_add);
+                    return tm_abort(region, transaction);
+                }
+
+                // A version greater than the transaction version requires to extend the snapshot
+                if(post_lock_status >> 0x1 > transaction->rv && !tm_extend(region, transaction, lock_index, post_lock_status)) {
+                    if(transaction->abort_cause == StatsCounter::aborts_read_version) {
+                        region->recordConflict(HeatmapEvent::version_failure, lock_index, (void *) source_word_add);
+                    }
+                    return tm_abort(region, transaction);
+                }
+
+                // Add the lock to the read-set
+                transaction->readSet->add(lock_index);
+            }
+        }
+    }
+
+    return true;
+}
+
+/** Write words in a read-write transaction of the tl2 or norec engine, the values are buffered in the write-set.
+ * @param region      Shared memory region associated with the transaction
+ * @param transaction Transaction to use
+ * @param source      Source start address (in a private region)
+ * @param size        Length to copy (in bytes), must be a positive multiple of the alignment
+ * @param target      Target start address (in the shared region)
+ * @return Whether the whole transaction can continue
+ * @throw std::bad_alloc if the write-set cannot grow, the transaction must then be aborted
+**/
+template<size_t WordSize>
+static bool tm_write_words(Region* region, Transaction* transaction, void const* source, size_t size, void* target) {
+    const size_t align = WordSize != 0 ? WordSize : region->align;
+    WriteSet *writeSet = transaction->writeSet.get();
+
+    // A single word written again is updated in place, anything else is appended to the ranges
+    if(size == align) {
+        void *value = writeSet->get(target);
+        if(value) {
+            word_copy<WordSize>(value, source, align);
+            return true;
+        }
+    }
+    writeSet->write(target, source, size, align, transaction->arena.get());
+
+    return true;
+}
 
 /** Create (i.e. allocate + init) a new shared memory region, with one first non-free-able allocated segment of the requested size and alignment.
  * @param size  Size of the first shared segment of memory to allocate (in bytes), must be a positive multiple of the alignment
  * @param align Alignment (in bytes, must be a power of 2) that the shared memory region must support
+ * The size of the lock table is derived from size/align unless TM_LOCK_TABLE_SIZE is set.
  * @return Opaque shared memory region handle, 'invalid_shared' on failure
 **/
 shared_t tm_create(size_t size, size_t align) noexcept {
     try {
-        return new Region(size, align);
+        return new Region(size, align, regionConfig_from_env(size, align));
     } catch (std::bad_alloc& e) {
         return invalid_shared;
     }
@@ -54,6 +351,15 @@ shared_t tm_create(size_t size, size_t align) noexcept {
 **/
 void tm_destroy(shared_t shared) noexcept {
     Region* region = static_cast<Region*>(shared);
+    if(region->heatmap) {
+        region->heatmap->dump(region->heatmap->getFile(), region->getLockCount());
+    }
+    if(region->latency) {
+        region->latency->dump(region->latency->getFile());
+    }
+    if(region->trace) {
+        region->trace->dump(region->trace->getFile());
+    }
     delete region;
 }
 
@@ -89,9 +395,45 @@ size_t tm_align(shared_t shared) noexcept {
 tx_t tm_begin(shared_t shared, bool is_ro) noexcept {
 
     Region* region = static_cast<Region*>(shared);
-    Transaction *transaction = new Transaction(is_ro,region->getClockVersion());
+    StatsSlot *stats = region->stats.slot();
+
+    // The epoch of the transaction is announced before it reads anything, and so is the snapshot
+    // of a read-only transaction in multi-version mode
+    size_t epoch_slot = region->epochs.enter();
+    VersionHistory *history = region->getHistory();
+    size_t reader_slot = history && is_ro ? history->registerReader() : MV_READER_SLOTS;
+    if(epoch_slot == EBR_SLOTS || (history && is_ro && reader_slot == MV_READER_SLOTS)) {
+        stats->add(StatsCounter::slot_overflows);
+    }
 
-    return (tx_t) transaction;
+    try {
+        uint64_t rv = region->engine == TmEngine::norec ? norec_snapshot(region) : region->getClockVersion();
+        Transaction *transaction = transaction_acquire(is_ro, rv);
+        transaction->epoch_slot = epoch_slot;
+        transaction->stats = stats;
+        transaction->latency = nullptr;
+        if(region->latency && region->latency->sample()) {
+            transaction->latency = region->latency->slot();
+            transaction->begin_time = Latency::now();
+        }
+        transaction->trace = region->trace ? region->trace->buffer() : nullptr;
+        if(transaction->trace) {
+            transaction->trace->record(TraceEvent::begin, Latency::now(), nullptr, 0, is_ro);
+        }
+        if(reader_slot != MV_READER_SLOTS) {
+            history->publishReader(reader_slot, rv);
+            transaction->reader_slot = reader_slot;
+        }
+        contentionManager_on_begin(region, transaction);
+        return (tx_t) transaction;
+    } catch (std::bad_alloc& e) {
+        if(reader_slot != MV_READER_SLOTS) {
+            history->unregisterReader(reader_slot);
+        }
+        region->epochs.exit(epoch_slot);
+        stats->add(StatsCounter::begin_failures);
+        return invalid_tx;
+    }
 }
 
 /** [thread-safe] End the given transaction.
@@ -103,68 +445,86 @@ bool tm_end(shared_t shared, tx_t tx) noexcept {
 
     Region* region = static_cast<Region*>(shared);
     Transaction *transaction = (Transaction *) tx;
-
-    if(transaction->is_ro || transaction->writeList->getHead() == nullptr) {
-        delete transaction;
-        return true;
+    if(transaction->latency) {
+        transaction->commit_time = Latency::now();
     }
 
-    // Upper bound of concurrent accesses to locks to avoid starvation
-    if(region->current_txs.load() > MAX_SIMUL_TXS) {
-        delete transaction;
-        return false;
+    if(region->engine == TmEngine::etl) {
+        if(!etl_commit(region, transaction)) {
+            return tm_abort(region, transaction);
+        }
+        return tm_committed(region, transaction);
     }
 
-    // Increment the number of transactions
-    region->current_txs.fetch_add(1);
+    if(transaction->is_ro || transaction->writeSet->getHead() == nullptr) {
+        return tm_committed(region, transaction);
+    }
 
-    // Try to aquire all locks in the write-set, if any lock is already taken, abort the transaction
-    Node *node = transaction->writeList->getHead();
-    while(node) {
-        int lock_index = ((uintptr_t) node->address) % LOCK_ARRAY_SIZE;
-        if(!region->acquireSpinLock(lock_index)) {
+    if(region->engine == TmEngine::norec) {
+        if(!norec_commit(region, transaction)) {
+            return tm_abort(region, transaction);
+        }
+        return tm_committed(region, transaction);
+    }
 
-            // Release the locks that were aquired
-            Node *locked_node = transaction->writeList->getHead();
-            while(locked_node && locked_node != node) {
-                region->releaseSpinLock(((uintptr_t) locked_node->address) % LOCK_ARRAY_SIZE);
-                locked_node = locked_node->next;
+    // Try to aquire all locks in the write-set, once each and in increasing index order, so that committers
+    // never wait for each other in a cycle. When a lock is already taken, the contention manager decides
+    // whether to wait for it or to abort the transaction.
+    try {
+        transaction_sort_write_locks(transaction, region);
+    } catch (std::bad_alloc& e) {
+        transaction->abort_cause = StatsCounter::aborts_no_memory;
+        return tm_abort(region, transaction);
+    }
+    uint64_t phase_start = transaction->latency ? Latency::now() : 0;
+    for(size_t i = 0; i < transaction->write_lock_count; i++) {
+        size_t lock_index = transaction->write_locks[i];
+        unsigned int attempt = 0;
+        while(!region->acquireSpinLock(lock_index)) {
+            if(region->sampleConflict()) {
+                region->heatmap->record(HeatmapEvent::acquire_failure, lock_index, transaction_write_address(transaction, region, lock_index));
+            }
+            if(!contentionManager_on_conflict(region, transaction, lock_index, attempt++)) {
+                // Release the locks that were aquired
+                transaction_release_write_locks(transaction, region, i);
+                transaction->abort_cause = StatsCounter::aborts_lock_busy;
+                return tm_abort(region, transaction);
             }
-
-            region->current_txs.fetch_sub(1);
-            delete transaction;
-            return false;
         }
-
-        node = node->next;
+        contentionManager_on_acquire(region, transaction, lock_index);
+    }
+    if(transaction->latency) {
+        uint64_t now = Latency::now();
+        transaction->latency->record(LatencyPhase::lock_acquisition, now - phase_start);
+        phase_start = now;
     }
 
-    // Increment the global version clock and store it in wv
-    transaction->wv = region->incrementClockVersion();
+    // Generate the write version from the global version clock
+    bool must_validate;
+    transaction->wv = region->generateWriteVersion(transaction->rv, &must_validate);
 
     // validate for each location in the read-set that the
     // version number associated with the versioned-write-lock is <= rv. We also
-    // verify that these memory locations have not been locked by other threads.
-    node = transaction->readList->getHead();
-    if(transaction->rv + 1 != transaction->wv) {
-        while(node) {
-            int lock_index = ((uintptr_t) node->address) % LOCK_ARRAY_SIZE;
-            int lock_state = region->getSpinLockState(lock_index);
-
-            if(lock_state >> 0x1 > transaction->rv || lock_state & 0x1) {
+    // verify that these memory locations have not been locked by other threads:
+    // a word whose lock is also a write lock is locked by this transaction.
+    if(must_validate) {
+        for(size_t lock_index : *transaction->readSet) {
+            uint64_t lock_state = region->getSpinLockState(lock_index);
+
+            if(lock_state >> 0x1 > transaction->rv
+                    || (lock_state & 0x1 && !transaction_has_write_lock(transaction, lock_index))) {
+                region->observeVersion(lock_state >> 0x1);
+                region->recordConflict(HeatmapEvent::version_failure, lock_index, nullptr);
+
                 // Release all the locks that were aquired
-                Node *locked_node = transaction->writeList->getHead();
-                while(locked_node) {
-                    region->releaseSpinLock(((uintptr_t) locked_node->address) % LOCK_ARRAY_SIZE);
-                    locked_node = locked_node->next;
-                }
+                transaction_release_write_locks(transaction, region, transaction->write_lock_count);
+                transaction->abort_cause = StatsCounter::aborts_validation;
 
-                region->current_txs.fetch_sub(1);
-                delete transaction;
-                return false;
+                return tm_abort(region, transaction);
             }
-
-            node = node->next;
+        }
+        if(transaction->latency) {
+            transaction->latency->record(LatencyPhase::validation, Latency::now() - phase_start);
         }
     }
 
@@ -172,11 +532,9 @@ bool tm_end(shared_t shared, tx_t tx) noexcept {
     // to the location the new value from the write-set and release the locations
     // lock by setting the version value to the write-version wv and clearing the
     // write-lock bit
-    transaction_commit_and_release_locks(transaction, region->getSpinLocks(), region->align);
+    transaction_commit_and_release_locks(transaction, region);
 
-    region->current_txs.fetch_sub(1);
-    delete transaction;
-    return true;
+    return tm_committed(region, transaction);
 }
 
 /** [thread-safe] Read operation in the given transaction, source in the shared region and target in a private region.
@@ -191,66 +549,37 @@ bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* ta
 
     Region* region = static_cast<Region*>(shared);
     Transaction *transaction = (Transaction *) tx;
+    transaction->accesses += size / region->align;
+    if(transaction->trace) {
+        transaction->trace->record(TraceEvent::read, Latency::now(), source, size, 0);
+    }
 
-    if(transaction->is_ro) {
-        for(size_t i = 0; i < size; i += region->align) {
-            uintptr_t source_word_add = (uintptr_t) source + i;
-            uintptr_t target_word_add = (uintptr_t) target + i;
-            int lock_index = ((uintptr_t) source + i) % LOCK_ARRAY_SIZE;
-
-            // Speculative execution
-            int pre_lock_status = region->getSpinLockState(lock_index);
-            memcpy((void *) target_word_add, (void *) source_word_add, region->align);
-            int post_lock_status = region->getSpinLockState(lock_index);
-
-            // Check if the lock has changed, if the version is greater than the transaction version or if the lock is taken
-            if (pre_lock_status != post_lock_status
-                    || post_lock_status >> 0x1 > transaction->rv
-                    || post_lock_status & 0x1) {
-
-                // Abort the transaction
-                delete transaction;
-                return false;
+    // The read-set and the read log grow as the words are read
+    try {
+        if(region->engine == TmEngine::norec) {
+            if(!norec_read(region, transaction, source, size, target)) {
+                return tm_abort(region, transaction);
             }
+            return true;
         }
-    }
-    else {
-        for(size_t i = 0; i < size; i += region->align) {
-            uintptr_t source_word_add = (uintptr_t) source + i;
-            uintptr_t target_word_add = (uintptr_t) target + i;
-
-            // see if the load address already appears in the write-set.
-            Node *node = transaction->writeList->get((void *) source_word_add);
-            if(node) {
-                memcpy((void *) target_word_add, node->val, region->align);
-                continue;
+        if(region->engine == TmEngine::etl) {
+            if(!etl_read(region, transaction, source, size, target)) {
+                return tm_abort(region, transaction);
             }
-            else {
-                int lock_index = (source_word_add) % LOCK_ARRAY_SIZE;
-
-                // Speculative execution
-                int pre_lock_status = region->getSpinLockState(lock_index);
-                memcpy((void *) target_word_add, (void *) source_word_add, region->align);
-                int post_lock_status = region->getSpinLockState(lock_index);
-
-                // Check if the lock has changed, if the version is greater than the transaction version or if the lock is taken
-                if (pre_lock_status != post_lock_status
-                        || post_lock_status >> 0x1 > transaction->rv
-                        || post_lock_status & 0x1) {
-
-                    // Abort the transaction
-                    delete transaction;
-                    return false;
-                }
+            return true;
+        }
 
-                // Add the address to the read-set
-                Node *newNode = new Node((void *) source_word_add, nullptr, region->align);
-                transaction->readList->add(newNode);
-            }
+        switch(region->word_size) {
+            case sizeof(uint64_t):
+                return tm_read_words<sizeof(uint64_t)>(region, transaction, source, size, target);
+            case sizeof(uint32_t):
+                return tm_read_words<sizeof(uint32_t)>(region, transaction, source, size, target);
+            default:
+                return tm_read_words<0>(region, transaction, source, size, target);
         }
+    } catch (std::bad_alloc& e) {
+        return tm_abort_no_memory(region, transaction);
     }
-
-    return true;
 }
 
 /** [thread-safe] Write operation in the given transaction, source in a private region and target in the shared region.
@@ -265,23 +594,31 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
 
     Region* region = static_cast<Region*>(shared);
     Transaction *transaction = (Transaction *) tx;
+    transaction->accesses += size / region->align;
+    if(transaction->trace) {
+        transaction->trace->record(TraceEvent::write, Latency::now(), target, size, 0);
+    }
 
-    for (size_t i = 0; i < size; i += region->align) {
-        uintptr_t source_word_add = (uintptr_t) source + i;
-        uintptr_t target_word_add = (uintptr_t) target + i;
-        LinkedList *writeList = transaction->writeList;
-
-        Node *node = writeList->get((void *) target_word_add);
-        if(node) {
-            memcpy(node->val, (void *) source_word_add, region->align);
+    // The write-set grows as the words are written
+    try {
+        if(region->engine == TmEngine::etl) {
+            if(!etl_write(region, transaction, source, size, target)) {
+                return tm_abort(region, transaction);
+            }
+            return true;
         }
-        else {
-            Node *newNode = new Node((void *) target_word_add, (void *) source_word_add, region->align);
-            writeList->add(newNode);
+
+        switch(region->word_size) {
+            case sizeof(uint64_t):
+                return tm_write_words<sizeof(uint64_t)>(region, transaction, source, size, target);
+            case sizeof(uint32_t):
+                return tm_write_words<sizeof(uint32_t)>(region, transaction, source, size, target);
+            default:
+                return tm_write_words<0>(region, transaction, source, size, target);
         }
+    } catch (std::bad_alloc& e) {
+        return tm_abort_no_memory(region, transaction);
     }
-
-    return true;
 }
 
 /** [thread-safe] Memory allocation in the given transaction.
@@ -291,36 +628,29 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
  * @param target Pointer in private memory receiving the address of the first byte of the newly allocated, aligned segment
  * @return Whether the whole transaction can continue (success/nomem), or not (abort_alloc)
 **/
-Alloc tm_alloc(shared_t shared, tx_t unused(tx), size_t size, void** target) noexcept {
+Alloc tm_alloc(shared_t shared, tx_t tx, size_t size, void** target) noexcept {
 
     Region* region = static_cast<Region*>(shared);
+    Transaction *transaction = (Transaction *) tx;
 
-    // We allocate the dynamic segment such that its words are correctly aligned.
-    // Moreover, the alignment of the 'next' and 'prev' pointers must be satisfied.
-    // Thus, we use align on max(align, struct segment_node*).
-    size_t align = region->align;
-    align = align < sizeof(struct segment_node*) ? sizeof(void*) : align;
-
-    struct segment_node* sn;
-    if (unlikely(posix_memalign((void**)&sn, align, sizeof(struct segment_node) + size) != 0)) {
+    // Segments are aligned on the alignment of the region, and come zero-filled
+    segment_list sn = region->allocator.allocate(size);
+    if (unlikely(!sn)) {
+        transaction->stats->add(StatsCounter::alloc_failures);
         return Alloc::nomem;
     }
 
-    // Lock the segment list
-    region->lockSegmentList();
-
-    // Insert in the linked list
-    sn->prev = nullptr;
-    sn->next = region->getAllocs();
-    if (sn->next) sn->next->prev = sn;
-    region->setAllocs(sn);
-
-    void* segment = (void*) ((uintptr_t) sn + sizeof(struct segment_node));
-    memset(segment, 0, size);
-    *target = segment;
-
-    // Unlock the segment list
-    region->unlockSegmentList();
+    // The segment is released if the transaction aborts
+    try {
+        Node *node = transaction_new_node(transaction, sn, nullptr, 0);
+        transaction->allocated->add(node);
+    } catch (std::bad_alloc& e) {
+        region->allocator.deallocate(sn);
+        transaction->stats->add(StatsCounter::alloc_failures);
+        return Alloc::nomem;
+    }
+    transaction->stats->add(StatsCounter::allocs);
+    *target = SegmentAllocator::segmentStart(sn);
 
     return Alloc::success;
 }
@@ -331,7 +661,95 @@ Alloc tm_alloc(shared_t shared, tx_t unused(tx), size_t size, void** target) noe
  * @param target Address of the first byte of the previously allocated segment to deallocate
  * @return Whether the whole transaction can continue
 **/
-bool tm_free(shared_t unused(shared), tx_t unused(tx), void* unused(target)) noexcept {
-    // Already freed when the transaction ends
+bool tm_free(shared_t shared, tx_t tx, void* target) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    Transaction *transaction = (Transaction *) tx;
+
+    // Freed when the transaction commits, and reclaimed once no running transaction can access the segment anymore
+    segment_list sn = SegmentAllocator::segmentNode(target);
+    try {
+        Node *node = transaction_new_node(transaction, sn, nullptr, 0);
+        transaction->freed->add(node);
+    } catch (std::bad_alloc& e) {
+        return tm_abort_no_memory(region, transaction);
+    }
+    transaction->stats->add(StatsCounter::frees);
     return true;
 }
+
+/** [thread-safe] Return the name of the contention policy of the given shared memory region.
+ * @param shared Shared memory region to query
+ * @return Name of the policy, as accepted by TM_CONTENTION
+**/
+const char* tm_contention_policy(shared_t shared) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    return contentionManager_policy_names[static_cast<size_t>(region->contention_policy)];
+}
+
+/** [thread-safe] Sum the statistics of the given shared memory region.
+ * The counters keep changing while they are summed, so the fields may not add up exactly.
+ * @param shared Shared memory region to query
+ * @param stats  Receives the statistics since the region was created
+**/
+void tm_stats(shared_t shared, tm_stats_t* stats) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    stats->commits = region->stats.total(StatsCounter::commits);
+    stats->commits_ro = region->stats.total(StatsCounter::commits_ro);
+    stats->aborts_read_version = region->stats.total(StatsCounter::aborts_read_version);
+    stats->aborts_validation = region->stats.total(StatsCounter::aborts_validation);
+    stats->aborts_lock_busy = region->stats.total(StatsCounter::aborts_lock_busy);
+    stats->aborts_no_memory = region->stats.total(StatsCounter::aborts_no_memory);
+    stats->aborts = stats->aborts_read_version + stats->aborts_validation + stats->aborts_lock_busy + stats->aborts_no_memory;
+    stats->begin_failures = region->stats.total(StatsCounter::begin_failures);
+    stats->slot_overflows = region->stats.total(StatsCounter::slot_overflows);
+    stats->read_set_words = region->stats.total(StatsCounter::read_set_words);
+    stats->write_set_words = region->stats.total(StatsCounter::write_set_words);
+    stats->allocs = region->stats.total(StatsCounter::allocs);
+    stats->alloc_failures = region->stats.total(StatsCounter::alloc_failures);
+    stats->frees = region->stats.total(StatsCounter::frees);
+}
+
+/** [thread-safe] Write the contention heatmap of the given shared memory region to a file.
+ * @param shared Shared memory region to query
+ * @param path   Path of the file, overwritten
+ * @return Whether the file was written, false if the heatmap is disabled (TM_HEATMAP)
+**/
+bool tm_heatmap_dump(shared_t shared, const char* path) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    return region->heatmap && region->heatmap->dump(path, region->getLockCount());
+}
+
+/** [thread-safe] Return a percentile of the latency histograms of the given shared memory region.
+ * @param shared   Shared memory region to query
+ * @param phase    Duration to query
+ * @param fraction Fraction of the timed transactions, between 0 and 1 (e.g. 0.99 for the 99th percentile)
+ * @return Duration in nanoseconds, 0 if the histograms are disabled (TM_LATENCY) or empty
+**/
+uint64_t tm_latency_percentile(shared_t shared, TmLatency phase, double fraction) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    if(!region->latency) {
+        return 0;
+    }
+    return region->latency->percentile(static_cast<LatencyPhase>(phase), fraction);
+}
+
+/** [thread-safe] Write the latency histograms of the given shared memory region to a file.
+ * @param shared Shared memory region to query
+ * @param path   Path of the file, overwritten
+ * @return Whether the file was written, false if the histograms are disabled (TM_LATENCY)
+**/
+bool tm_latency_dump(shared_t shared, const char* path) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    return region->latency && region->latency->dump(path);
+}
+
+/** [thread-safe] Write the transaction trace of the given shared memory region to a file, in the Chrome
+ * trace_event JSON format. The threads may keep running, the events they overwrite meanwhile are left out.
+ * @param shared Shared memory region to query
+ * @param path   Path of the file, overwritten
+ * @return Whether the file was written, false if the trace is disabled (TM_TRACE)
+**/
+bool tm_trace_dump(shared_t shared, const char* path) noexcept {
+    Region* region = static_cast<Region*>(shared);
+    return region->trace && region->trace->dump(path);
+}